@@ -1,5 +1,9 @@
 #pragma once
 
+#include "KeyCompare.h"
+#include "NodeStorage.h"
+
+#include <algorithm>
 #include <memory>
 #include <random>
 #include <utility>
@@ -7,64 +11,94 @@
 #include <iostream>
 #include <iterator>
 #include <string>
-
-template <typename K, typename V, typename IteratorTag = std::forward_iterator_tag>
+#include <vector>
+
+// Base of the trees, Derived is the concrete tree (CRTP) and provides
+//   template <typename Key> NodePtr find(const NodePtr& node, const Key& key) const
+// which is called statically, so lookups through the base inline into the derived search loop.
+// Keys are ordered by Compare, see KeyCompare.h; transparent comparators enable lookups by other key types.
+// Derived trees add their own insert and remove; AnyBST.h wraps a tree for callers that need runtime polymorphism.
+template <typename Derived, typename K, typename V, typename IteratorTag = std::forward_iterator_tag, typename Storage = SharedNodeStorage, typename Compare = ThreeWayCompare<K>>
 class AbstractBST {
 protected:
 	struct AbstractNode;
 
-	template <bool enabled>
-	struct NextNodeInterface;
-
-	template <>
-	struct NextNodeInterface<false> {};
+	// Backward steps for iterators of trees declared with std::bidirectional_iterator_tag.
+	template <typename Iterator, bool enabled>
+	struct NextNodeInterface {};
 
-	template <>
-	struct NextNodeInterface<true> {
-		virtual std::shared_ptr<AbstractNode> prev() const = 0;
+	template <typename Iterator>
+	struct NextNodeInterface<Iterator, true> {
+		Iterator& operator--();
+		Iterator operator--(int);
 	};
 
 public:
 	class NodeIterator;
+	class Range;
 
 	using iterator = NodeIterator;
 	using const_iterator = const NodeIterator;
 	using KVPair = std::pair<K, V>;
+	using KeyCompare = Compare;
 
-	AbstractBST() = default;
+	template <typename Key>
+	using EnableLookup = std::enable_if_t<IsTransparentCompare<Compare, Key>::value>;
 
 	bool contains(const K& key) const;
+	template <typename Key, typename = EnableLookup<Key>>
+	bool contains(const Key& key) const;
 
-	virtual iterator find(const K& key) const;
-
-	virtual void insert(const K& key, const V& value) = 0;
-	
-	virtual bool remove(const K& key) = 0;
+	iterator find(const K& key) const;
+	template <typename Key, typename = EnableLookup<Key>>
+	iterator find(const Key& key) const;
 
 	void clear();
 
 	size_t size() const;
 
-	virtual iterator begin() const;
+	// Order statistics over the subtree sizes kept in every node, O(height).
+	iterator select(size_t index) const;
+	size_t rank(const K& key) const;
+	size_t countRange(const K& low, const K& high) const;
+
+	// Ordered queries, O(height) to locate the bound plus O(1) amortized per visited element.
+	iterator lowerBound(const K& key) const;
+	iterator upperBound(const K& key) const;
+	std::pair<iterator, iterator> equalRange(const K& key) const;
+	iterator floor(const K& key) const;
+	iterator ceiling(const K& key) const;
+	Range range(const K& low, const K& high) const;
+
+	template <typename Key, typename = EnableLookup<Key>>
+	iterator lowerBound(const Key& key) const;
+	template <typename Key, typename = EnableLookup<Key>>
+	iterator upperBound(const Key& key) const;
+	template <typename Key, typename = EnableLookup<Key>>
+	std::pair<iterator, iterator> equalRange(const Key& key) const;
+	template <typename Key, typename = EnableLookup<Key>>
+	iterator floor(const Key& key) const;
+	template <typename Key, typename = EnableLookup<Key>>
+	iterator ceiling(const Key& key) const;
+
+	KeyCompare keyCompare() const;
+
+	iterator begin() const;
 	const_iterator cbegin() const;
 
 	iterator end() const;
 	const_iterator cend() const;
 
-	class NodeIterator final : public std::iterator<IteratorTag, typename AbstractNode::Ptr> {
+	// In-order iterator keeping the path to the current node, each step is O(1) amortized and touches no reference counts.
+	// Iterators compare by node identity and are invalidated by modifications of the tree.
+	class NodeIterator final : public std::iterator<IteratorTag, KVPair>,
+	                           public NextNodeInterface<NodeIterator, std::is_same<IteratorTag, std::bidirectional_iterator_tag>::value> {
 	public:
 		NodeIterator() = default;
-		NodeIterator(typename AbstractNode::Ptr ptr);
-		NodeIterator(const NodeIterator& other);
 
 		NodeIterator& operator++();
 		NodeIterator operator++(int);
 
-		template <typename = typename std::enable_if<std::is_same<IteratorTag, std::bidirectional_iterator_tag>::value>>
-		NodeIterator& operator--();
-		template <typename = typename std::enable_if<std::is_same<IteratorTag, std::bidirectional_iterator_tag>::value>>
-		NodeIterator operator--(int);
-
 		bool operator==(const NodeIterator& other) const;
 		bool operator!=(const NodeIterator& other) const;
 
@@ -77,173 +111,639 @@ public:
 		operator bool() const;
 
 	private:
-		typename AbstractNode::Ptr m_item;
+		friend class AbstractBST;
+		friend struct NextNodeInterface<NodeIterator, true>;
+
+		NodeIterator(const AbstractBST* tree, AbstractNode* node);
+
+		void retreat();
+		void restoreAncestors();
+
+		const AbstractBST* m_tree{ nullptr };
+		AbstractNode* m_node{ nullptr };
+		std::vector<AbstractNode*> m_ancestors;
+		bool m_hasAncestors{ false };
+	};
+
+	// Elements with keys in [low, high], usable in range-based for loops.
+	class Range final {
+	public:
+		Range(iterator first, iterator last);
+
+		iterator begin() const;
+		iterator end() const;
+
+		bool empty() const;
+
+	private:
+		iterator m_first;
+		iterator m_last;
 	};
 
 protected:
-	struct AbstractNode : public NextNodeInterface<std::is_same<IteratorTag, std::bidirectional_iterator_tag>::value> {
-		using Ptr = std::shared_ptr<AbstractNode>;
-		using WPtr = std::weak_ptr<AbstractNode>;
+	AbstractBST() = default;
+	explicit AbstractBST(const Compare& compare);
+	AbstractBST(const AbstractBST& other) = default;
+	AbstractBST(AbstractBST&& other) noexcept;
+	~AbstractBST();
+
+	AbstractBST& operator=(const AbstractBST& other) = default;
+	AbstractBST& operator=(AbstractBST&& other) noexcept;
+
+	struct AbstractNode {
+		using Pool = typename Storage::template Pool<AbstractNode>;
+		using Ptr = typename Pool::Ptr;
+		using WPtr = typename Pool::WPtr;
 
 		AbstractNode(const KVPair& keyValue);
+		AbstractNode(KVPair&& keyValue);
+
+		// Constructs the key-value pair in place from args.
+		template <typename... Args>
+		explicit AbstractNode(std::in_place_t, Args&&... args);
+
+		virtual ~AbstractNode() = default;
 
-		virtual Ptr next() const = 0;
+		Ptr parent() const;
 
 		KVPair m_keyValue;
 		size_t m_size{ 1 };
-		WPtr m_parent;
-		Ptr m_left;
-		Ptr m_right;
+		WPtr m_parent{};
+		Ptr m_left{};
+		Ptr m_right{};
 	};
 
 	using NodePtr = typename AbstractNode::Ptr;
 
-	NodePtr mostLeftNode() const;
+	Derived& derived();
+	const Derived& derived() const;
 
-	virtual NodePtr find(const NodePtr& node, const K& key) const = 0;
+	iterator makeIterator(const NodePtr& node) const;
 
-	virtual NodePtr insert(NodePtr& node, const KVPair& keyValue) = 0;
+	size_t safeGetSize(const NodePtr& node) const;
+	size_t countLess(const K& key, bool inclusive) const;
 
-	virtual NodePtr remove(NodePtr& p, const K& key) = 0;
+	template <typename Key>
+	NodePtr findNode(const Key& key) const;
+	template <typename Key>
+	NodePtr boundNode(const Key& key, bool upper) const;
+	template <typename Key>
+	NodePtr floorNode(const Key& key) const;
 
-	NodePtr m_rootNode;
+	template <typename A, typename B>
+	bool keyLess(const A& lhs, const B& rhs) const;
+	template <typename A, typename B>
+	int compareKeys(const A& lhs, const B& rhs) const;
+
+	template <typename T, typename... Args>
+	NodePtr createNode(Args&&... args);
+	void destroyNode(NodePtr& node);
+
+	// Builds a balanced subtree of nodes of type T from count sorted items, advancing it past them.
+	template <typename T, typename InputIt>
+	NodePtr buildFromSorted(InputIt& it, size_t count);
+
+	typename AbstractNode::Pool m_nodePool;
+	NodePtr m_rootNode{};
 	size_t m_size{ 0 };
+	Compare m_compare{};
 };
 
-template <typename K, typename V, typename IteratorTag>
-bool AbstractBST<K, V, IteratorTag>::contains(const K& key) const {
-	return find(m_rootNode, key) != nullptr;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::AbstractBST(const Compare& compare) :
+    m_compare(compare)
+{
 }
 
-template <typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::iterator AbstractBST<K, V, IteratorTag>::find(const K& key) const {
-	auto ptr = find(m_rootNode, key);
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::AbstractBST(AbstractBST&& other) noexcept {
+	*this = std::move(other);
+}
 
-	return iterator(ptr);
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::~AbstractBST() {
+	clear();
 }
 
-template <typename K, typename V, typename IteratorTag>
-void AbstractBST<K, V, IteratorTag>::clear() {
-	m_rootNode.reset();
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>& AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::operator=(AbstractBST&& other) noexcept {
+	if (this != &other) {
+		clear();
+		m_nodePool = std::move(other.m_nodePool);
+		m_rootNode = std::exchange(other.m_rootNode, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_compare = std::move(other.m_compare);
+	}
+
+	return *this;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+bool AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::contains(const K& key) const {
+	return findNode(key) != nullptr;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key, typename>
+bool AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::contains(const Key& key) const {
+	return findNode(key) != nullptr;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::find(const K& key) const {
+	return makeIterator(findNode(key));
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key, typename>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::find(const Key& key) const {
+	return makeIterator(findNode(key));
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+void AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::clear() {
+	m_nodePool.release(m_rootNode);
 	m_size = 0;
 }
 
-template <typename K, typename V, typename IteratorTag>
-size_t AbstractBST<K, V, IteratorTag>::size() const {
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+size_t AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::size() const {
 	return m_size;
 }
 
-template <typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::iterator AbstractBST<K, V, IteratorTag>::begin() const {
-	return iterator(mostLeftNode());
+// Returns the node with the given zero-based position in key order, or end() if there is none.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::select(size_t index) const {
+	auto link = &m_rootNode;
+
+	while (*link) {
+		const auto leftSize = safeGetSize((*link)->m_left);
+
+		if (index < leftSize) {
+			link = &(*link)->m_left;
+		} else if (index == leftSize) {
+			return makeIterator(*link);
+		} else {
+			index -= leftSize + 1;
+			link = &(*link)->m_right;
+		}
+	}
+
+	return end();
 }
 
-template <typename K, typename V, typename IteratorTag>
-const typename AbstractBST<K, V, IteratorTag>::iterator AbstractBST<K, V, IteratorTag>::cbegin() const {
-	return begin();
+// Number of keys strictly less than key.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+size_t AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::rank(const K& key) const {
+	return countLess(key, false);
 }
 
-template <typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::iterator AbstractBST<K, V, IteratorTag>::end() const {
-	return iterator();
+// Number of keys in [low, high].
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+size_t AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::countRange(const K& low, const K& high) const {
+	if (keyLess(high, low)) {
+		return 0;
+	}
+
+	return countLess(high, true) - countLess(low, false);
+}
+
+// First element with a key not less than key.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::lowerBound(const K& key) const {
+	return makeIterator(boundNode(key, false));
+}
+
+// First element with a key greater than key.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::upperBound(const K& key) const {
+	return makeIterator(boundNode(key, true));
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+std::pair<typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator, typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::equalRange(const K& key) const {
+	return std::make_pair(lowerBound(key), upperBound(key));
+}
+
+// Last element with a key not greater than key.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::floor(const K& key) const {
+	return makeIterator(floorNode(key));
+}
+
+// First element with a key not less than key.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::ceiling(const K& key) const {
+	return lowerBound(key);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::Range AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::range(const K& low, const K& high) const {
+	if (keyLess(high, low)) {
+		return Range(end(), end());
+	}
+
+	return Range(lowerBound(low), upperBound(high));
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key, typename>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::lowerBound(const Key& key) const {
+	return makeIterator(boundNode(key, false));
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key, typename>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::upperBound(const Key& key) const {
+	return makeIterator(boundNode(key, true));
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key, typename>
+std::pair<typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator, typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::equalRange(const Key& key) const {
+	return std::make_pair(lowerBound(key), upperBound(key));
 }
 
-template <typename K, typename V, typename IteratorTag>
-const typename AbstractBST<K, V, IteratorTag>::iterator AbstractBST<K, V, IteratorTag>::cend() const {
-	return const_iterator();
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key, typename>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::floor(const Key& key) const {
+	return makeIterator(floorNode(key));
 }
 
-template <typename K, typename V, typename IteratorTag>
-AbstractBST<K, V, IteratorTag>::NodeIterator::NodeIterator(NodePtr ptr) {
-	m_item = ptr;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key, typename>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::ceiling(const Key& key) const {
+	return lowerBound(key);
 }
 
-template <typename K, typename V, typename IteratorTag>
-AbstractBST<K, V, IteratorTag>::NodeIterator::NodeIterator(const typename AbstractBST<K, V, IteratorTag>::NodeIterator& other) {
-	*this = other;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::KeyCompare AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::keyCompare() const {
+	return m_compare;
 }
 
-template <typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::NodeIterator& AbstractBST<K, V, IteratorTag>::NodeIterator::operator++() {
-	m_item = m_item->next();
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::begin() const {
+	iterator it(this, nullptr);
+
+	auto node = m_rootNode ? &*m_rootNode : nullptr;
+	while (node && node->m_left) {
+		it.m_ancestors.push_back(node);
+		node = &*node->m_left;
+	}
+
+	it.m_node = node;
+	it.m_hasAncestors = true;
+
+	return it;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+const typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::cbegin() const {
+	return begin();
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::end() const {
+	return iterator(this, nullptr);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+const typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::cend() const {
+	return end();
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::NodeIterator(const AbstractBST* tree, AbstractNode* node) :
+    m_tree(tree),
+    m_node(node)
+{
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator& AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator++() {
+	if (!m_hasAncestors) {
+		restoreAncestors();
+	}
+
+	if (m_node->m_right) {
+		m_ancestors.push_back(m_node);
+		m_node = &*m_node->m_right;
+
+		while (m_node->m_left) {
+			m_ancestors.push_back(m_node);
+			m_node = &*m_node->m_left;
+		}
+
+		return *this;
+	}
+
+	auto child = m_node;
+	m_node = nullptr;
+
+	while (!m_ancestors.empty()) {
+		auto parent = m_ancestors.back();
+		m_ancestors.pop_back();
+
+		if (parent->m_left && &*parent->m_left == child) {
+			m_node = parent;
+			break;
+		}
+
+		child = parent;
+	}
+
 	return *this;
 }
 
-template <typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::NodeIterator AbstractBST<K, V, IteratorTag>::NodeIterator::operator++(int) {
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator++(int) {
 	auto tmp = *this;
 	operator++();
 	return tmp;
 }
 
-template <typename K, typename V, typename IteratorTag> template <typename >
-typename AbstractBST<K, V, IteratorTag>::NodeIterator& AbstractBST<K, V, IteratorTag>::NodeIterator::operator--() {
-	m_item = m_item->prev();
-	return *this;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Iterator>
+Iterator& AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NextNodeInterface<Iterator, true>::operator--() {
+	auto& self = static_cast<Iterator&>(*this);
+	self.retreat();
+	return self;
 }
 
-template <typename K, typename V, typename IteratorTag> template <typename >
-typename AbstractBST<K, V, IteratorTag>::NodeIterator AbstractBST<K, V, IteratorTag>::NodeIterator::operator--(int) {
-	auto tmp = *this;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Iterator>
+Iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NextNodeInterface<Iterator, true>::operator--(int) {
+	auto tmp = static_cast<Iterator&>(*this);
 	operator--();
 	return tmp;
 }
 
-template <typename K, typename V, typename IteratorTag>
-bool AbstractBST<K, V, IteratorTag>::NodeIterator::operator==(const NodeIterator& other) const {
-	if (!m_item && !other.m_item) {
-		return true;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+bool AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator==(const NodeIterator& other) const {
+	return m_node == other.m_node;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+bool AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator!=(const NodeIterator& other) const {
+	return !(*this == other);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::KVPair& AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator*() {
+	return m_node->m_keyValue;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+const typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::KVPair& AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator*() const {
+	return m_node->m_keyValue;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::KVPair* AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator->() {
+	return &m_node->m_keyValue;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+const typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::KVPair* AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator->() const {
+	return &m_node->m_keyValue;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::operator bool() const {
+	return m_node != nullptr;
+}
+
+// Steps back from end() to the last element, or to the in-order predecessor otherwise.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+void AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::retreat() {
+	if (!m_node) {
+		m_ancestors.clear();
+
+		auto node = m_tree->m_rootNode ? &*m_tree->m_rootNode : nullptr;
+		while (node && node->m_right) {
+			m_ancestors.push_back(node);
+			node = &*node->m_right;
+		}
+
+		m_node = node;
+		m_hasAncestors = true;
+		return;
 	}
 
-	if (!other.m_item || !m_item) {
-		return false;
+	if (!m_hasAncestors) {
+		restoreAncestors();
 	}
 
-	return m_item->m_keyValue == other.m_item->m_keyValue;
+	if (m_node->m_left) {
+		m_ancestors.push_back(m_node);
+		m_node = &*m_node->m_left;
+
+		while (m_node->m_right) {
+			m_ancestors.push_back(m_node);
+			m_node = &*m_node->m_right;
+		}
+
+		return;
+	}
+
+	auto child = m_node;
+	m_node = nullptr;
+
+	while (!m_ancestors.empty()) {
+		auto parent = m_ancestors.back();
+		m_ancestors.pop_back();
+
+		if (parent->m_right && &*parent->m_right == child) {
+			m_node = parent;
+			break;
+		}
+
+		child = parent;
+	}
 }
 
-template <typename K, typename V, typename IteratorTag>
-bool AbstractBST<K, V, IteratorTag>::NodeIterator::operator!=(const NodeIterator& other) const {
-	return !(*this == other);
+// Iterators created from a single node (find, bounds, select) learn their path lazily from the parent links.
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+void AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodeIterator::restoreAncestors() {
+	m_ancestors.clear();
+
+	for (auto parent = m_node->parent(); parent; parent = parent->parent()) {
+		m_ancestors.push_back(&*parent);
+	}
+
+	std::reverse(m_ancestors.begin(), m_ancestors.end());
+	m_hasAncestors = true;
 }
 
-template <typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::KVPair& AbstractBST<K, V, IteratorTag>::NodeIterator::operator*() {
-	return m_item->m_keyValue;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::Range::Range(iterator first, iterator last) :
+    m_first(first),
+    m_last(last)
+{
 }
 
-template <typename K, typename V, typename IteratorTag>
-const typename AbstractBST<K, V, IteratorTag>::KVPair& AbstractBST<K, V, IteratorTag>::NodeIterator::operator*() const {
-	return m_item->m_keyValue;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::Range::begin() const {
+	return m_first;
 }
 
-template <typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::KVPair* AbstractBST<K, V, IteratorTag>::NodeIterator::operator->() {
-	return &m_item->m_keyValue;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::Range::end() const {
+	return m_last;
 }
 
-template <typename K, typename V, typename IteratorTag>
-const typename AbstractBST<K, V, IteratorTag>::KVPair* AbstractBST<K, V, IteratorTag>::NodeIterator::operator->() const {
-	return &m_item->m_keyValue;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+bool AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::Range::empty() const {
+	return m_first == m_last;
 }
 
-template <typename K, typename V, typename IteratorTag>
-AbstractBST<K, V, IteratorTag>::NodeIterator::operator bool() const {
-	return m_item != nullptr;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::AbstractNode::AbstractNode(const KVPair& keyValue) :
+    m_keyValue(keyValue)
+{
 }
 
-template <typename K, typename V, typename IteratorTag>
-AbstractBST<K, V, IteratorTag>::AbstractNode::AbstractNode(const KVPair& keyValue) {
-	m_keyValue = keyValue;
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::AbstractNode::AbstractNode(KVPair&& keyValue) :
+    m_keyValue(std::move(keyValue))
+{
 }
 
-template<typename K, typename V, typename IteratorTag>
-typename AbstractBST<K, V, IteratorTag>::NodePtr AbstractBST<K, V, IteratorTag>::mostLeftNode() const
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename... Args>
+AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::AbstractNode::AbstractNode(std::in_place_t, Args&&... args) :
+    m_keyValue(std::forward<Args>(args)...)
 {
-	auto ptr = m_rootNode;
-	while (ptr && ptr->m_left) {
-		ptr = ptr->m_left;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::AbstractNode::Ptr AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::AbstractNode::parent() const {
+	return Pool::lock(m_parent);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+size_t AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::safeGetSize(const NodePtr& node) const {
+	if (node) {
+		return node->m_size;
+	}
+
+	return 0;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+size_t AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::countLess(const K& key, bool inclusive) const {
+	auto count = size_t{ 0 };
+	auto link = &m_rootNode;
+
+	while (*link) {
+		const auto& node = *link;
+		const auto goesRight = inclusive ? !keyLess(key, node->m_keyValue.first) : keyLess(node->m_keyValue.first, key);
+
+		if (goesRight) {
+			count += safeGetSize(node->m_left) + 1;
+			link = &node->m_right;
+		} else {
+			link = &node->m_left;
+		}
+	}
+
+	return count;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodePtr AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::findNode(const Key& key) const {
+	return derived().find(m_rootNode, key);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodePtr AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::boundNode(const Key& key, bool upper) const {
+	NodePtr result{};
+	auto link = &m_rootNode;
+
+	while (*link) {
+		const auto& node = *link;
+		const auto goesLeft = upper ? keyLess(key, node->m_keyValue.first) : !keyLess(node->m_keyValue.first, key);
+
+		if (goesLeft) {
+			result = node;
+			link = &node->m_left;
+		} else {
+			link = &node->m_right;
+		}
 	}
 
-	return ptr;
+	return result;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+Derived& AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::derived() {
+	return static_cast<Derived&>(*this);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+const Derived& AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::derived() const {
+	return static_cast<const Derived&>(*this);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename Key>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodePtr AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::floorNode(const Key& key) const {
+	NodePtr result{};
+	auto link = &m_rootNode;
+
+	while (*link) {
+		if (keyLess(key, (*link)->m_keyValue.first)) {
+			link = &(*link)->m_left;
+		} else {
+			result = *link;
+			link = &(*link)->m_right;
+		}
+	}
+
+	return result;
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename A, typename B>
+bool AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::keyLess(const A& lhs, const B& rhs) const {
+	return m_compare(lhs, rhs);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename A, typename B>
+int AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::compareKeys(const A& lhs, const B& rhs) const {
+	return threeWayCompare(m_compare, lhs, rhs);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::iterator AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::makeIterator(const NodePtr& node) const {
+	return iterator(this, node ? &*node : nullptr);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename T, typename... Args>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodePtr AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::createNode(Args&&... args) {
+	return m_nodePool.template create<T>(std::forward<Args>(args)...);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare>
+void AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::destroyNode(NodePtr& node) {
+	m_nodePool.destroy(node);
+}
+
+template <typename Derived, typename K, typename V, typename IteratorTag, typename Storage, typename Compare> template <typename T, typename InputIt>
+typename AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::NodePtr AbstractBST<Derived, K, V, IteratorTag, Storage, Compare>::buildFromSorted(InputIt& it, size_t count) {
+	if (count == 0) {
+		return NodePtr{};
+	}
+
+	const auto leftCount = count / 2;
+	auto left = buildFromSorted<T>(it, leftCount);
+
+	auto node = createNode<T>(*it);
+	++it;
+
+	auto right = buildFromSorted<T>(it, count - leftCount - 1);
+
+	if (left) {
+		left->m_parent = node;
+	}
+
+	if (right) {
+		right->m_parent = node;
+	}
+
+	node->m_left = left;
+	node->m_right = right;
+	node->m_size = count;
+
+	return node;
 }
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Move-only owning handle over any tree with the AbstractBST interface plus insert and remove,
+// for code that chooses the tree at runtime. Every call costs a virtual dispatch, hot paths should use the tree directly.
+template <typename K, typename V>
+class AnyBST {
+public:
+	template <typename Tree, typename = std::enable_if_t<!std::is_same<std::decay_t<Tree>, AnyBST>::value>>
+	AnyBST(Tree&& tree);
+
+	AnyBST(AnyBST&& other) noexcept = default;
+
+	AnyBST& operator=(AnyBST&& other) noexcept = default;
+
+	bool contains(const K& key) const;
+
+	// Value stored under key, or nullptr if there is none.
+	const V* find(const K& key) const;
+
+	void insert(const K& key, const V& value);
+
+	bool remove(const K& key);
+
+	void clear();
+
+	size_t size() const;
+
+	// Visits the elements in key order.
+	void forEach(const std::function<void(const K&, const V&)>& visitor) const;
+
+	// The wrapped tree if it has type Tree, nullptr otherwise.
+	template <typename Tree>
+	Tree* target();
+
+	template <typename Tree>
+	const Tree* target() const;
+
+private:
+	struct Concept {
+		virtual ~Concept() = default;
+
+		virtual bool contains(const K& key) const = 0;
+		virtual const V* find(const K& key) const = 0;
+		virtual void insert(const K& key, const V& value) = 0;
+		virtual bool remove(const K& key) = 0;
+		virtual void clear() = 0;
+		virtual size_t size() const = 0;
+		virtual void forEach(const std::function<void(const K&, const V&)>& visitor) const = 0;
+	};
+
+	template <typename Tree>
+	struct Model final : public Concept {
+		explicit Model(Tree tree);
+
+		bool contains(const K& key) const override;
+		const V* find(const K& key) const override;
+		void insert(const K& key, const V& value) override;
+		bool remove(const K& key) override;
+		void clear() override;
+		size_t size() const override;
+		void forEach(const std::function<void(const K&, const V&)>& visitor) const override;
+
+		Tree m_tree;
+	};
+
+	std::unique_ptr<Concept> m_model;
+};
+
+template <typename K, typename V> template <typename Tree, typename>
+AnyBST<K, V>::AnyBST(Tree&& tree) :
+    m_model(std::make_unique<Model<std::decay_t<Tree>>>(std::forward<Tree>(tree)))
+{
+}
+
+template <typename K, typename V>
+bool AnyBST<K, V>::contains(const K& key) const {
+	return m_model->contains(key);
+}
+
+template <typename K, typename V>
+const V* AnyBST<K, V>::find(const K& key) const {
+	return m_model->find(key);
+}
+
+template <typename K, typename V>
+void AnyBST<K, V>::insert(const K& key, const V& value) {
+	m_model->insert(key, value);
+}
+
+template <typename K, typename V>
+bool AnyBST<K, V>::remove(const K& key) {
+	return m_model->remove(key);
+}
+
+template <typename K, typename V>
+void AnyBST<K, V>::clear() {
+	m_model->clear();
+}
+
+template <typename K, typename V>
+size_t AnyBST<K, V>::size() const {
+	return m_model->size();
+}
+
+template <typename K, typename V>
+void AnyBST<K, V>::forEach(const std::function<void(const K&, const V&)>& visitor) const {
+	m_model->forEach(visitor);
+}
+
+template <typename K, typename V> template <typename Tree>
+Tree* AnyBST<K, V>::target() {
+	auto model = dynamic_cast<Model<Tree>*>(m_model.get());
+	return model ? &model->m_tree : nullptr;
+}
+
+template <typename K, typename V> template <typename Tree>
+const Tree* AnyBST<K, V>::target() const {
+	auto model = dynamic_cast<const Model<Tree>*>(m_model.get());
+	return model ? &model->m_tree : nullptr;
+}
+
+template <typename K, typename V> template <typename Tree>
+AnyBST<K, V>::Model<Tree>::Model(Tree tree) :
+    m_tree(std::move(tree))
+{
+}
+
+template <typename K, typename V> template <typename Tree>
+bool AnyBST<K, V>::Model<Tree>::contains(const K& key) const {
+	return m_tree.contains(key);
+}
+
+template <typename K, typename V> template <typename Tree>
+const V* AnyBST<K, V>::Model<Tree>::find(const K& key) const {
+	const auto it = m_tree.find(key);
+	return it != m_tree.end() ? &it->second : nullptr;
+}
+
+template <typename K, typename V> template <typename Tree>
+void AnyBST<K, V>::Model<Tree>::insert(const K& key, const V& value) {
+	m_tree.insert(key, value);
+}
+
+template <typename K, typename V> template <typename Tree>
+bool AnyBST<K, V>::Model<Tree>::remove(const K& key) {
+	return m_tree.remove(key);
+}
+
+template <typename K, typename V> template <typename Tree>
+void AnyBST<K, V>::Model<Tree>::clear() {
+	m_tree.clear();
+}
+
+template <typename K, typename V> template <typename Tree>
+size_t AnyBST<K, V>::Model<Tree>::size() const {
+	return m_tree.size();
+}
+
+template <typename K, typename V> template <typename Tree>
+void AnyBST<K, V>::Model<Tree>::forEach(const std::function<void(const K&, const V&)>& visitor) const {
+	for (const auto& keyValue : m_tree) {
+		visitor(keyValue.first, keyValue.second);
+	}
+}
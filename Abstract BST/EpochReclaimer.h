@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Process-wide epoch-based reclamation for trees whose readers follow links without locks.
+// Readers pin the current epoch for the duration of an operation, an unlinked node is retired instead of deleted
+// and freed only once every thread pinned at the time of its removal has unpinned, i.e. two epochs later.
+// Pinning costs a store and a fence on a per-thread slot, readers never write shared cache lines.
+class EpochReclaimer {
+public:
+	// Keeps the calling thread pinned while alive, guards may nest.
+	class Guard {
+	public:
+		Guard(Guard&& other) noexcept;
+		~Guard();
+
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+		Guard& operator=(Guard&&) = delete;
+
+	private:
+		friend class EpochReclaimer;
+
+		explicit Guard(EpochReclaimer* reclaimer);
+
+		EpochReclaimer* m_reclaimer;
+	};
+
+	static EpochReclaimer& instance();
+
+	Guard pin();
+
+	// Deletes object once no thread can hold a reference obtained before this call.
+	template <typename T>
+	void retire(T* object);
+
+	// Advances the epoch if every pinned thread has seen it and frees what the calling thread retired long enough ago.
+	void collect();
+
+private:
+	struct Retired {
+		void* object;
+		void (*destroy)(void*);
+		uint64_t epoch;
+	};
+
+	// Per-thread state, reused by later threads after its thread exits.
+	struct Slot {
+		std::atomic<uint64_t> pinnedEpoch{ 0 };
+		std::atomic<bool> inUse{ false };
+		Slot* next{ nullptr };
+		unsigned depth{ 0 };
+		std::vector<Retired> retired;
+		size_t collectAt{ collectThreshold };
+	};
+
+	// Returns the slot of the thread to the reclaimer when the thread exits.
+	struct ThreadSlot {
+		~ThreadSlot();
+
+		Slot* slot{ nullptr };
+	};
+
+	// Retired objects that trigger the first collect. While a pinned thread holds the epoch back, the trigger
+	// doubles with what could not be freed, so retiring stays amortized O(1).
+	static constexpr size_t collectThreshold = 128;
+
+	EpochReclaimer() = default;
+
+	Slot& threadSlot();
+	Slot* acquireSlot();
+
+	void enter();
+	void leave();
+
+	void retire(void* object, void (*destroy)(void*));
+	bool tryAdvance();
+	void freeRetired(std::vector<Retired>& retired, uint64_t epoch);
+
+	std::atomic<uint64_t> m_epoch{ 1 };
+	std::atomic<Slot*> m_slots{ nullptr };
+
+	// Nodes retired by threads that exited before they could be freed.
+	std::mutex m_orphanMutex;
+	std::vector<Retired> m_orphans;
+};
+
+inline EpochReclaimer::Guard::Guard(EpochReclaimer* reclaimer) :
+    m_reclaimer(reclaimer)
+{
+	m_reclaimer->enter();
+}
+
+inline EpochReclaimer::Guard::Guard(Guard&& other) noexcept :
+    m_reclaimer(other.m_reclaimer)
+{
+	other.m_reclaimer = nullptr;
+}
+
+inline EpochReclaimer::Guard::~Guard() {
+	if (m_reclaimer) {
+		m_reclaimer->leave();
+	}
+}
+
+// Never destroyed, so threads that exit during static destruction can still hand back their slots.
+inline EpochReclaimer& EpochReclaimer::instance() {
+	static auto* reclaimer = new EpochReclaimer();
+	return *reclaimer;
+}
+
+inline EpochReclaimer::Guard EpochReclaimer::pin() {
+	return Guard(this);
+}
+
+template <typename T>
+void EpochReclaimer::retire(T* object) {
+	retire(object, [](void* retired) { delete static_cast<T*>(retired); });
+}
+
+inline void EpochReclaimer::collect() {
+	tryAdvance();
+
+	const auto epoch = m_epoch.load();
+	freeRetired(threadSlot().retired, epoch);
+
+	std::unique_lock<std::mutex> lock(m_orphanMutex, std::try_to_lock);
+	if (lock.owns_lock()) {
+		freeRetired(m_orphans, epoch);
+	}
+}
+
+inline EpochReclaimer::ThreadSlot::~ThreadSlot() {
+	if (!slot) {
+		return;
+	}
+
+	auto& reclaimer = instance();
+	reclaimer.freeRetired(slot->retired, reclaimer.m_epoch.load());
+
+	if (!slot->retired.empty()) {
+		std::lock_guard<std::mutex> lock(reclaimer.m_orphanMutex);
+		reclaimer.m_orphans.insert(reclaimer.m_orphans.end(), slot->retired.begin(), slot->retired.end());
+		slot->retired.clear();
+	}
+
+	slot->collectAt = collectThreshold;
+	slot->inUse.store(false);
+}
+
+inline EpochReclaimer::Slot& EpochReclaimer::threadSlot() {
+	thread_local ThreadSlot threadSlot;
+	if (!threadSlot.slot) {
+		threadSlot.slot = acquireSlot();
+	}
+
+	return *threadSlot.slot;
+}
+
+// Slots are never freed: a thread takes a released one or pushes a new one onto the list.
+inline EpochReclaimer::Slot* EpochReclaimer::acquireSlot() {
+	for (auto slot = m_slots.load(); slot; slot = slot->next) {
+		auto expected = false;
+		if (!slot->inUse.load() && slot->inUse.compare_exchange_strong(expected, true)) {
+			return slot;
+		}
+	}
+
+	auto slot = new Slot();
+	slot->inUse.store(true);
+	slot->next = m_slots.load();
+	while (!m_slots.compare_exchange_weak(slot->next, slot)) {
+	}
+
+	return slot;
+}
+
+// A pinned slot holds the epoch it entered, readers of the epoch may lag behind by one before the fence.
+inline void EpochReclaimer::enter() {
+	auto& slot = threadSlot();
+	if (slot.depth++ == 0) {
+		slot.pinnedEpoch.store(m_epoch.load());
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+}
+
+inline void EpochReclaimer::leave() {
+	auto& slot = threadSlot();
+	if (--slot.depth == 0) {
+		slot.pinnedEpoch.store(0, std::memory_order_release);
+	}
+}
+
+// The fence orders the caller's unlinking store, which may be a release store, before the epoch is read,
+// so a reader pinned in a later epoch cannot still load the unlinked object.
+inline void EpochReclaimer::retire(void* object, void (*destroy)(void*)) {
+	auto& slot = threadSlot();
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	slot.retired.push_back(Retired{ object, destroy, m_epoch.load() });
+
+	if (slot.retired.size() >= slot.collectAt) {
+		collect();
+		slot.collectAt = std::max(collectThreshold, 2 * slot.retired.size());
+	}
+}
+
+inline bool EpochReclaimer::tryAdvance() {
+	auto epoch = m_epoch.load();
+
+	for (auto slot = m_slots.load(); slot; slot = slot->next) {
+		const auto pinned = slot->pinnedEpoch.load();
+		if (pinned != 0 && pinned != epoch) {
+			return false;
+		}
+	}
+
+	return m_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+// An object retired in epoch e may still be reachable by threads pinned in e - 1 or e, both are gone by e + 2.
+inline void EpochReclaimer::freeRetired(std::vector<Retired>& retired, uint64_t epoch) {
+	const auto expired = std::partition(retired.begin(), retired.end(), [epoch](const Retired& item) {
+		return item.epoch + 2 > epoch;
+	});
+
+	for (auto it = expired; it != retired.end(); ++it) {
+		it->destroy(it->object);
+	}
+
+	retired.erase(expired, retired.end());
+}
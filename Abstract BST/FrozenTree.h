@@ -0,0 +1,399 @@
+#pragma once
+
+#include "KeyCompare.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FROZEN_TREE_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define FROZEN_TREE_PREFETCH(address) ((void)(address))
+#endif
+
+// Placement of the implicit search tree in the key array. Node k of the complete binary tree has children 2k and
+// 2k + 1, a layout places them given the slots of k and its ancestors on the search path, indexed by depth.
+// The right child always sits a fixed step after the left one, so a search computes both before the comparison
+// and the comparison only picks one. Layouts that place a node by its index alone skip recording the path.
+
+// Breadth-first order, slot k holds node k: the first levels of every search share a few cache lines and the
+// 16 descendants of k four levels down share the line at 16k for 4-byte keys, so a search prefetches them.
+class EytzingerLayout {
+public:
+	static constexpr bool usesPath = false;
+
+	explicit EytzingerLayout(size_t count = 0);
+
+	size_t slotCount() const;
+	size_t rootSlot() const;
+	size_t leftChild(size_t index, size_t depth, const size_t* path) const;
+	size_t rightStep(size_t depth) const;
+
+	template <typename K>
+	void prefetch(const K* keys, size_t index, size_t left, size_t step) const;
+
+private:
+	size_t m_count;
+};
+
+// Recursive blocked order: a tree of height h is cut at half its height, the top tree is stored first, followed
+// by each bottom tree in order, all laid out the same way. A search touches O(log_B n) blocks for every block size
+// B at once, so it stays cache and TLB friendly on every level of the memory hierarchy without tuning.
+// The slot of a node follows from the slot of the root of its enclosing top tree (Brodal, Fagerberg and Jacob):
+// for each depth the tables hold that root's depth, the size of the top tree and the size of each bottom tree.
+// Nodes past count are left empty, so the array can take up to twice the keys of the breadth-first one.
+// Descendants further down are not known without the comparisons, a search prefetches both children.
+class VanEmdeBoasLayout {
+public:
+	static constexpr bool usesPath = true;
+
+	explicit VanEmdeBoasLayout(size_t count = 0);
+
+	size_t slotCount() const;
+	size_t rootSlot() const;
+	size_t leftChild(size_t index, size_t depth, const size_t* path) const;
+	size_t rightStep(size_t depth) const;
+
+	template <typename K>
+	void prefetch(const K* keys, size_t index, size_t left, size_t step) const;
+
+private:
+	static constexpr size_t maxHeight = 64;
+
+	void split(size_t depth, size_t height);
+
+	size_t m_height{ 0 };
+	std::array<size_t, maxHeight> m_topDepth{};
+	std::array<size_t, maxHeight> m_topSize{};
+	std::array<size_t, maxHeight> m_bottomSize{};
+};
+
+// Read-only sorted map for trees that stop changing, e.g. after a bulk load.
+// Keys sit in one array in the order of Layout, by default breadth-first (Eytzinger). The search is branchless
+// and ends at the lower bound. Elements are kept in key order for iteration and values, a node maps to its element
+// through m_order.
+template <typename K, typename V, typename Compare = ThreeWayCompare<K>, typename Layout = EytzingerLayout>
+class FrozenTree {
+public:
+	using KVPair = std::pair<K, V>;
+	using iterator = typename std::vector<KVPair>::const_iterator;
+	using const_iterator = iterator;
+
+	FrozenTree();
+
+	// Elements of a range sorted by key.
+	template <typename InputIt>
+	FrozenTree(InputIt first, InputIt last, const Compare& compare = Compare());
+
+	bool contains(const K& key) const;
+
+	iterator find(const K& key) const;
+
+	iterator lowerBound(const K& key) const;
+	iterator upperBound(const K& key) const;
+
+	// Number of elements with keys less than key.
+	size_t rank(const K& key) const;
+
+	size_t size() const;
+	bool empty() const;
+
+	iterator begin() const;
+	iterator end() const;
+
+private:
+	static constexpr size_t cacheLine = 64;
+
+	// Keys start at a cache line, so blocks of the layout line up with cache lines.
+	template <typename T>
+	struct CacheLineAllocator {
+		using value_type = T;
+
+		template <typename U>
+		struct rebind {
+			using other = CacheLineAllocator<U>;
+		};
+
+		CacheLineAllocator() = default;
+		template <typename U>
+		CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+		T* allocate(size_t count);
+		void deallocate(T* pointer, size_t count);
+
+		bool operator==(const CacheLineAllocator&) const { return true; }
+		bool operator!=(const CacheLineAllocator&) const { return false; }
+	};
+
+	static constexpr size_t maxDepth = 64;
+
+	// Node found by a search and its slot in m_keys.
+	struct Bound {
+		size_t index;
+		size_t slot;
+	};
+
+	// Fills the subtree of index placed at slot in key order, next is the next element to place.
+	void layout(size_t index, size_t depth, size_t slot, size_t* path, size_t& next);
+
+	// Node of the first key not less than key, or with upper of the first key greater than key, index 0 if none is.
+	template <bool upper>
+	Bound search(const K& key) const;
+
+	// Node of an element with key, 0 if there is none. The compared key is still cached from the search.
+	size_t findIndex(const K& key) const;
+
+	static size_t trailingOnes(size_t value);
+
+	std::vector<KVPair> m_items;
+	Layout m_layout;
+	std::vector<K, CacheLineAllocator<K>> m_keys;
+	std::vector<size_t> m_order;
+	Compare m_compare{};
+};
+
+// Freezes any tree whose iteration yields key-value pairs in key order and that exposes its comparator.
+template <typename Layout = EytzingerLayout, typename Tree>
+FrozenTree<typename Tree::KVPair::first_type, typename Tree::KVPair::second_type, typename Tree::KeyCompare, Layout> freeze(const Tree& tree) {
+	return FrozenTree<typename Tree::KVPair::first_type, typename Tree::KVPair::second_type, typename Tree::KeyCompare, Layout>(
+	    tree.begin(), tree.end(), tree.keyCompare());
+}
+
+inline EytzingerLayout::EytzingerLayout(size_t count) :
+    m_count(count)
+{
+}
+
+// Slot 0 stays unused.
+inline size_t EytzingerLayout::slotCount() const {
+	return m_count + 1;
+}
+
+inline size_t EytzingerLayout::rootSlot() const {
+	return 1;
+}
+
+inline size_t EytzingerLayout::leftChild(size_t index, size_t, const size_t*) const {
+	return 2 * index;
+}
+
+inline size_t EytzingerLayout::rightStep(size_t) const {
+	return 1;
+}
+
+template <typename K>
+void EytzingerLayout::prefetch(const K* keys, size_t index, size_t, size_t) const {
+	constexpr auto stride = sizeof(K) >= 64 ? size_t{ 1 } : 64 / sizeof(K);
+	FROZEN_TREE_PREFETCH(reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(keys) + index * stride * sizeof(K)));
+}
+
+inline VanEmdeBoasLayout::VanEmdeBoasLayout(size_t count) {
+	for (; (count >> m_height) != 0; ++m_height) {
+	}
+
+	split(0, m_height);
+}
+
+inline size_t VanEmdeBoasLayout::slotCount() const {
+	return std::max<size_t>((size_t{ 1 } << m_height) - 1, 1);
+}
+
+inline size_t VanEmdeBoasLayout::rootSlot() const {
+	return 0;
+}
+
+// Every child is the root of a bottom tree on some level of the recursion: it follows its top tree, and the low
+// bits of its index below the top tree root pick the bottom tree. Top trees have odd sizes, so the right child
+// lands in the next bottom tree.
+inline size_t VanEmdeBoasLayout::leftChild(size_t index, size_t depth, const size_t* path) const {
+	const auto child = depth + 1;
+	return path[m_topDepth[child]] + m_topSize[child] + ((2 * index) & m_topSize[child]) * m_bottomSize[child];
+}
+
+inline size_t VanEmdeBoasLayout::rightStep(size_t depth) const {
+	return m_bottomSize[depth + 1];
+}
+
+template <typename K>
+void VanEmdeBoasLayout::prefetch(const K* keys, size_t, size_t left, size_t step) const {
+	FROZEN_TREE_PREFETCH(keys + left);
+	FROZEN_TREE_PREFETCH(keys + left + step);
+}
+
+// Records the bottom tree roots of the subtree rooted at depth, then recurses into its top and bottom halves.
+inline void VanEmdeBoasLayout::split(size_t depth, size_t height) {
+	if (height <= 1) {
+		return;
+	}
+
+	const auto topHeight = height / 2;
+	const auto bottomHeight = height - topHeight;
+
+	m_topDepth[depth + topHeight] = depth;
+	m_topSize[depth + topHeight] = (size_t{ 1 } << topHeight) - 1;
+	m_bottomSize[depth + topHeight] = (size_t{ 1 } << bottomHeight) - 1;
+
+	split(depth, topHeight);
+	split(depth + topHeight, bottomHeight);
+}
+
+// Index 0 of the layout stands for a search that never went left, it maps to end().
+template <typename K, typename V, typename Compare, typename Layout>
+FrozenTree<K, V, Compare, Layout>::FrozenTree() :
+    m_keys(m_layout.slotCount()),
+    m_order(1, 0)
+{
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+template <typename InputIt>
+FrozenTree<K, V, Compare, Layout>::FrozenTree(InputIt first, InputIt last, const Compare& compare) :
+    m_items(first, last),
+    m_layout(m_items.size()),
+    m_keys(m_layout.slotCount()),
+    m_order(m_items.size() + 1, m_items.size()),
+    m_compare(compare)
+{
+	size_t path[maxDepth];
+	auto next = size_t{ 0 };
+	layout(1, 0, m_layout.rootSlot(), path, next);
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+bool FrozenTree<K, V, Compare, Layout>::contains(const K& key) const {
+	return findIndex(key) != 0;
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+typename FrozenTree<K, V, Compare, Layout>::iterator FrozenTree<K, V, Compare, Layout>::find(const K& key) const {
+	return m_items.begin() + static_cast<std::ptrdiff_t>(m_order[findIndex(key)]);
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+typename FrozenTree<K, V, Compare, Layout>::iterator FrozenTree<K, V, Compare, Layout>::lowerBound(const K& key) const {
+	return m_items.begin() + static_cast<std::ptrdiff_t>(m_order[search<false>(key).index]);
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+typename FrozenTree<K, V, Compare, Layout>::iterator FrozenTree<K, V, Compare, Layout>::upperBound(const K& key) const {
+	return m_items.begin() + static_cast<std::ptrdiff_t>(m_order[search<true>(key).index]);
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+size_t FrozenTree<K, V, Compare, Layout>::rank(const K& key) const {
+	return m_order[search<false>(key).index];
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+size_t FrozenTree<K, V, Compare, Layout>::size() const {
+	return m_items.size();
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+bool FrozenTree<K, V, Compare, Layout>::empty() const {
+	return m_items.empty();
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+typename FrozenTree<K, V, Compare, Layout>::iterator FrozenTree<K, V, Compare, Layout>::begin() const {
+	return m_items.begin();
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+typename FrozenTree<K, V, Compare, Layout>::iterator FrozenTree<K, V, Compare, Layout>::end() const {
+	return m_items.end();
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+template <typename T>
+T* FrozenTree<K, V, Compare, Layout>::CacheLineAllocator<T>::allocate(size_t count) {
+	return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(cacheLine)));
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+template <typename T>
+void FrozenTree<K, V, Compare, Layout>::CacheLineAllocator<T>::deallocate(T* pointer, size_t) {
+	::operator delete(pointer, std::align_val_t(cacheLine));
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+void FrozenTree<K, V, Compare, Layout>::layout(size_t index, size_t depth, size_t slot, size_t* path, size_t& next) {
+	if (index > m_items.size()) {
+		return;
+	}
+
+	path[depth] = slot;
+	const auto left = m_layout.leftChild(index, depth, path);
+	layout(2 * index, depth + 1, left, path, next);
+	m_keys[slot] = m_items[next].first;
+	m_order[index] = next++;
+	layout(2 * index + 1, depth + 1, left + m_layout.rightStep(depth), path, next);
+}
+
+// Each step appends one comparison bit to index, so the bits after the leading one spell the path.
+// The lower bound is the last node where the search went left: dropping the trailing right turns and that
+// left turn leads back to it, and index 0 means the search never went left.
+template <typename K, typename V, typename Compare, typename Layout>
+template <bool upper>
+typename FrozenTree<K, V, Compare, Layout>::Bound FrozenTree<K, V, Compare, Layout>::search(const K& key) const {
+	const auto count = m_items.size();
+	const auto keys = m_keys.data();
+
+	size_t path[maxDepth];
+	auto index = size_t{ 1 };
+	auto depth = size_t{ 0 };
+	auto slot = m_layout.rootSlot();
+	while (index <= count) {
+		if constexpr (Layout::usesPath) {
+			path[depth] = slot;
+		}
+
+		const auto left = m_layout.leftChild(index, depth, path);
+		const auto step = m_layout.rightStep(depth);
+		m_layout.prefetch(keys, index, left, step);
+
+		size_t right;
+		if constexpr (upper) {
+			right = static_cast<size_t>(!m_compare(key, keys[slot]));
+		} else {
+			right = static_cast<size_t>(m_compare(keys[slot], key));
+		}
+
+		index = 2 * index + right;
+		slot = left + (right ? step : 0);
+		++depth;
+	}
+
+	const auto turns = trailingOnes(index) + 1;
+	index >>= turns;
+	if constexpr (Layout::usesPath) {
+		return Bound{ index, index != 0 ? path[depth - turns] : 0 };
+	} else {
+		return Bound{ index, index };
+	}
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+size_t FrozenTree<K, V, Compare, Layout>::findIndex(const K& key) const {
+	const auto bound = search<false>(key);
+	return bound.index != 0 && !m_compare(key, m_keys[bound.slot]) ? bound.index : 0;
+}
+
+template <typename K, typename V, typename Compare, typename Layout>
+size_t FrozenTree<K, V, Compare, Layout>::trailingOnes(size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<size_t>(__builtin_ctzll(~static_cast<unsigned long long>(value)));
+#else
+	auto ones = size_t{ 0 };
+	for (; value & 1; value >>= 1) {
+		++ones;
+	}
+
+	return ones;
+#endif
+}
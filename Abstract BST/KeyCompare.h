@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Key ordering policies for AbstractBST.
+// A comparator is a less-than function object as for std::map. It may also provide
+//   int compare(const A& lhs, const B& rhs) const
+// returning a negative, zero or positive value, which lets a search decide each level with a single comparison.
+// Comparators declaring is_transparent accept lookup keys of other types than the key type.
+
+// Default ordering by operator<, strings and string views are compared in one pass.
+// ThreeWayCompare<> is transparent, e.g. std::string keys can be looked up by std::string_view.
+template <typename T = void>
+struct ThreeWayCompare {
+	bool operator()(const T& lhs, const T& rhs) const;
+
+	int compare(const T& lhs, const T& rhs) const;
+};
+
+template <>
+struct ThreeWayCompare<void> {
+	using is_transparent = void;
+
+	template <typename A, typename B>
+	bool operator()(const A& lhs, const B& rhs) const;
+
+	template <typename A, typename B>
+	int compare(const A& lhs, const B& rhs) const;
+};
+
+template <typename Compare, typename A, typename B, typename = void>
+struct HasThreeWayCompare : std::false_type {};
+
+template <typename Compare, typename A, typename B>
+struct HasThreeWayCompare<Compare, A, B, std::void_t<decltype(std::declval<const Compare&>().compare(std::declval<const A&>(), std::declval<const B&>()))>> : std::true_type {};
+
+// Enables lookups by Key when the comparator is transparent.
+template <typename Compare, typename Key, typename = void>
+struct IsTransparentCompare : std::false_type {};
+
+template <typename Compare, typename Key>
+struct IsTransparentCompare<Compare, Key, std::void_t<typename Compare::is_transparent>> : std::true_type {};
+
+// Three-way result of any comparator, falling back to two less-than calls when it has no compare().
+template <typename Compare, typename A, typename B>
+int threeWayCompare(const Compare& compare, const A& lhs, const B& rhs) {
+	if constexpr (HasThreeWayCompare<Compare, A, B>::value) {
+		return compare.compare(lhs, rhs);
+	} else {
+		return compare(lhs, rhs) ? -1 : (compare(rhs, lhs) ? 1 : 0);
+	}
+}
+
+template <typename T>
+bool ThreeWayCompare<T>::operator()(const T& lhs, const T& rhs) const {
+	return ThreeWayCompare<>()(lhs, rhs);
+}
+
+template <typename T>
+int ThreeWayCompare<T>::compare(const T& lhs, const T& rhs) const {
+	return ThreeWayCompare<>().compare(lhs, rhs);
+}
+
+template <typename A, typename B>
+bool ThreeWayCompare<void>::operator()(const A& lhs, const B& rhs) const {
+	return lhs < rhs;
+}
+
+template <typename A, typename B>
+int ThreeWayCompare<void>::compare(const A& lhs, const B& rhs) const {
+	if constexpr (std::is_convertible<const A&, std::string_view>::value && std::is_convertible<const B&, std::string_view>::value) {
+		return std::string_view(lhs).compare(std::string_view(rhs));
+	} else {
+		return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Process-wide background thread that runs deferred node destruction in submission order.
+// The thread starts with the first submission. It is never joined, so trees with static storage duration
+// can still hand it work at exit; work left in the queue when the process exits is dropped.
+class NodeReclaimer {
+public:
+	static NodeReclaimer& instance();
+
+	void submit(std::function<void()> work);
+
+	// Blocks until all work submitted so far has run.
+	void drain();
+
+private:
+	NodeReclaimer();
+
+	void run();
+
+	std::mutex m_mutex;
+	std::condition_variable m_workReady;
+	std::condition_variable m_idle;
+	std::deque<std::function<void()>> m_queue;
+	bool m_busy{ false };
+};
+
+inline NodeReclaimer& NodeReclaimer::instance() {
+	static auto* reclaimer = new NodeReclaimer();
+	return *reclaimer;
+}
+
+inline NodeReclaimer::NodeReclaimer() {
+	std::thread(&NodeReclaimer::run, this).detach();
+}
+
+inline void NodeReclaimer::submit(std::function<void()> work) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::move(work));
+	}
+
+	m_workReady.notify_one();
+}
+
+inline void NodeReclaimer::drain() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+}
+
+inline void NodeReclaimer::run() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true) {
+		m_workReady.wait(lock, [this] { return !m_queue.empty(); });
+
+		auto work = std::move(m_queue.front());
+		m_queue.pop_front();
+		m_busy = true;
+
+		lock.unlock();
+		work();
+		work = nullptr;
+		lock.lock();
+
+		m_busy = false;
+		if (m_queue.empty()) {
+			m_idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include "NodeReclaimer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Node storage policies for AbstractBST.
+// A policy exposes Pool<Node> which defines the handle types used for tree links
+// and is responsible for creating and destroying nodes of the tree that owns it.
+// Pools with transferable set let their nodes be relinked into another tree of the same type.
+
+// Reference counted nodes: children are owned through shared_ptr, parents are weak.
+// Released subtrees are taken apart iteratively, so deep trees cannot overflow the stack.
+struct SharedNodeStorage {
+	template <typename Node>
+	class Pool {
+	public:
+		using Ptr = std::shared_ptr<Node>;
+		using WPtr = std::weak_ptr<Node>;
+
+		static constexpr bool transferable = true;
+
+		template <typename T, typename... Args>
+		Ptr create(Args&&... args);
+
+		void destroy(Ptr& node);
+		void release(Ptr& root);
+
+		static Ptr lock(const WPtr& ptr);
+	};
+};
+
+// Reference counted nodes like SharedNodeStorage, but subtrees released by clear, destruction or bulk removals
+// are handed to the NodeReclaimer thread, so the caller does not wait for them to be destroyed.
+// Keys and values are destroyed on that thread. Once it runs, shared_ptr reference counts use atomic operations.
+struct DeferredNodeStorage {
+	template <typename Node>
+	class Pool : public SharedNodeStorage::Pool<Node> {
+	public:
+		using Ptr = typename SharedNodeStorage::Pool<Node>::Ptr;
+
+		void release(Ptr& root);
+	};
+};
+
+// Slab arena: nodes are bump allocated from slabs owned by the tree and handed out as raw pointers,
+// destroyed nodes are recycled through an intrusive free list.
+struct ArenaNodeStorage {
+	template <typename Node>
+	class Pool {
+	public:
+		using Ptr = Node*;
+		using WPtr = Node*;
+
+		static constexpr bool transferable = false;
+
+		Pool() = default;
+		Pool(const Pool&) = delete;
+		Pool(Pool&& other) noexcept;
+		~Pool() = default;
+
+		Pool& operator=(const Pool&) = delete;
+		Pool& operator=(Pool&& other) noexcept;
+
+		template <typename T, typename... Args>
+		Ptr create(Args&&... args);
+
+		void destroy(Ptr& node);
+		void release(Ptr& root);
+
+		static Ptr lock(const WPtr& ptr);
+
+	private:
+		struct FreeSlot {
+			FreeSlot* next;
+		};
+
+		static constexpr size_t firstSlabSlots = 64;
+		static constexpr size_t maxSlabSlots = 64 * 1024;
+
+		void *allocateSlot();
+		void rewind();
+
+		std::vector<std::unique_ptr<std::byte[]>> m_slabs;
+		std::byte* m_cursor{ nullptr };
+		std::byte* m_slabEnd{ nullptr };
+		FreeSlot* m_freeList{ nullptr };
+		size_t m_slotSize{ 0 };
+		size_t m_slabSlots{ firstSlabSlots };
+		size_t m_liveNodes{ 0 };
+	};
+};
+
+template <typename Node> template <typename T, typename... Args>
+typename SharedNodeStorage::Pool<Node>::Ptr SharedNodeStorage::Pool<Node>::create(Args&&... args) {
+	return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+template <typename Node>
+void SharedNodeStorage::Pool<Node>::destroy(Ptr& node) {
+	node.reset();
+}
+
+template <typename Node>
+void SharedNodeStorage::Pool<Node>::release(Ptr& root) {
+	std::vector<Ptr> stack;
+	if (root) {
+		stack.push_back(std::move(root));
+	}
+
+	// Children of a node nobody else holds are detached first, so each node is destroyed without recursing.
+	while (!stack.empty()) {
+		auto node = std::move(stack.back());
+		stack.pop_back();
+
+		if (node.use_count() == 1) {
+			if (node->m_left) {
+				stack.push_back(std::move(node->m_left));
+			}
+
+			if (node->m_right) {
+				stack.push_back(std::move(node->m_right));
+			}
+		}
+	}
+}
+
+template <typename Node>
+typename SharedNodeStorage::Pool<Node>::Ptr SharedNodeStorage::Pool<Node>::lock(const WPtr& ptr) {
+	return ptr.lock();
+}
+
+template <typename Node>
+void DeferredNodeStorage::Pool<Node>::release(Ptr& root) {
+	if (!root) {
+		return;
+	}
+
+	NodeReclaimer::instance().submit([subtree = std::move(root)]() mutable {
+		SharedNodeStorage::Pool<Node>().release(subtree);
+	});
+}
+
+template <typename Node>
+ArenaNodeStorage::Pool<Node>::Pool(Pool&& other) noexcept {
+	*this = std::move(other);
+}
+
+template <typename Node>
+typename ArenaNodeStorage::Pool<Node>& ArenaNodeStorage::Pool<Node>::operator=(Pool&& other) noexcept {
+	m_slabs = std::move(other.m_slabs);
+	m_cursor = std::exchange(other.m_cursor, nullptr);
+	m_slabEnd = std::exchange(other.m_slabEnd, nullptr);
+	m_freeList = std::exchange(other.m_freeList, nullptr);
+	m_slotSize = std::exchange(other.m_slotSize, 0);
+	m_slabSlots = std::exchange(other.m_slabSlots, firstSlabSlots);
+	m_liveNodes = std::exchange(other.m_liveNodes, 0);
+	other.m_slabs.clear();
+
+	return *this;
+}
+
+template <typename Node> template <typename T, typename... Args>
+typename ArenaNodeStorage::Pool<Node>::Ptr ArenaNodeStorage::Pool<Node>::create(Args&&... args) {
+	static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned nodes are not supported");
+
+	constexpr auto slotSize = ((std::max(sizeof(T), sizeof(FreeSlot)) + alignof(T) - 1) / alignof(T)) * alignof(T);
+	assert((m_slotSize == 0 || m_slotSize == slotSize) && "arena holds nodes of a single type");
+	m_slotSize = slotSize;
+
+	auto slot = allocateSlot();
+	auto node = new (slot) T(std::forward<Args>(args)...);
+	++m_liveNodes;
+
+	return node;
+}
+
+template <typename Node>
+void ArenaNodeStorage::Pool<Node>::destroy(Ptr& node) {
+	if (!node) {
+		return;
+	}
+
+	node->~Node();
+
+	auto slot = reinterpret_cast<FreeSlot*>(node);
+	slot->next = m_freeList;
+	m_freeList = slot;
+	node = nullptr;
+
+	if (--m_liveNodes == 0) {
+		rewind();
+	}
+}
+
+template <typename Node>
+void ArenaNodeStorage::Pool<Node>::release(Ptr& root) {
+	std::vector<Ptr> stack;
+	if (root) {
+		stack.push_back(root);
+	}
+
+	while (!stack.empty()) {
+		auto node = stack.back();
+		stack.pop_back();
+
+		if (node->m_left) {
+			stack.push_back(node->m_left);
+		}
+
+		if (node->m_right) {
+			stack.push_back(node->m_right);
+		}
+
+		destroy(node);
+	}
+
+	root = nullptr;
+}
+
+template <typename Node>
+typename ArenaNodeStorage::Pool<Node>::Ptr ArenaNodeStorage::Pool<Node>::lock(const WPtr& ptr) {
+	return ptr;
+}
+
+template <typename Node>
+void *ArenaNodeStorage::Pool<Node>::allocateSlot() {
+	if (m_freeList) {
+		return std::exchange(m_freeList, m_freeList->next);
+	}
+
+	if (m_cursor == m_slabEnd) {
+		const auto bytes = m_slotSize * m_slabSlots;
+		m_slabs.emplace_back(new std::byte[bytes]);
+		m_cursor = m_slabs.back().get();
+		m_slabEnd = m_cursor + bytes;
+		m_slabSlots = std::min(m_slabSlots * 2, maxSlabSlots);
+	}
+
+	return std::exchange(m_cursor, m_cursor + m_slotSize);
+}
+
+// Every node is gone: keep the largest slab and start bumping from its beginning again.
+template <typename Node>
+void ArenaNodeStorage::Pool<Node>::rewind() {
+	if (m_slabs.empty()) {
+		return;
+	}
+
+	auto last = std::move(m_slabs.back());
+	const auto bytes = static_cast<size_t>(m_slabEnd - last.get());
+	m_slabs.clear();
+	m_slabs.push_back(std::move(last));
+
+	m_cursor = m_slabs.back().get();
+	m_slabEnd = m_cursor + bytes;
+	m_freeList = nullptr;
+}
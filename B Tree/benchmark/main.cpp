@@ -0,0 +1,202 @@
+#include "BTree.h"
+
+#include <RBST.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const auto repetitions = 3;
+
+// Results are accumulated here so the optimizer cannot drop the measured work.
+volatile size_t sink = 0;
+
+template <typename F>
+double measureMs(F&& fn) {
+	auto best = std::numeric_limits<double>::max();
+
+	for (auto r = 0; r < repetitions; ++r) {
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	return best;
+}
+
+// Runs setup before every repetition and measures fn only.
+template <typename S, typename F>
+double measureMs(S&& setup, F&& fn) {
+	auto best = std::numeric_limits<double>::max();
+
+	for (auto r = 0; r < repetitions; ++r) {
+		setup();
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	return best;
+}
+
+void report(const std::string& name, double ms, size_t operations = 0) {
+	std::cout << "  " << std::left << std::setw(52) << name << std::right << std::setw(12) << std::fixed << std::setprecision(2) << ms << " ms";
+
+	if (operations > 0) {
+		std::cout << std::setw(12) << ms * 1e6 / static_cast<double>(operations) << " ns/op";
+	}
+
+	std::cout << std::endl;
+}
+
+std::vector<int> shuffledKeys(size_t count) {
+	std::vector<int> keys(count);
+	for (size_t i = 0; i < count; ++i) {
+		keys[i] = static_cast<int>(i);
+	}
+
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+	return keys;
+}
+
+std::vector<int> randomKeys(size_t count, size_t range) {
+	std::mt19937 random(42);
+	std::vector<int> keys(count);
+	for (auto& key : keys) {
+		key = static_cast<int>(random() % range);
+	}
+
+	return keys;
+}
+
+template <typename Tree>
+void lookupBenchmark(const std::string& name, size_t count, size_t lookups) {
+	Tree tree;
+	for (const auto key : shuffledKeys(count)) {
+		tree.insert(key, key);
+	}
+
+	const auto keys = randomKeys(lookups, count);
+	const auto ms = measureMs([&tree, &keys] {
+		auto found = size_t{ 0 };
+		for (const auto key : keys) {
+			found += tree.contains(key) ? 1 : 0;
+		}
+		sink = sink + found;
+	});
+
+	report(name + ", " + std::to_string(count) + " keys", ms, keys.size());
+}
+
+void pointLookupBenchmark(const std::vector<size_t>& sizes, size_t lookups) {
+	std::cout << "Random lookups, " << lookups << " lookups of int keys" << std::endl;
+
+	for (const auto count : sizes) {
+		lookupBenchmark<RBST<int, int>>("RBST", count, lookups);
+		lookupBenchmark<RBST<int, int, ArenaNodeStorage>>("RBST with ArenaNodeStorage", count, lookups);
+		lookupBenchmark<BTree<int, int>>("BTree", count, lookups);
+		lookupBenchmark<BTree<int, int, std::less<int>>>("BTree, binary search in nodes", count, lookups);
+	}
+}
+
+template <typename Tree>
+void insertRemoveBenchmark(const std::string& name, size_t count) {
+	const auto keys = shuffledKeys(count);
+
+	Tree tree;
+	const auto insertMs = measureMs([&tree] { tree.clear(); }, [&tree, &keys] {
+		for (const auto key : keys) {
+			tree.insert(key, key);
+		}
+	});
+
+	report(name + ", insert", insertMs, keys.size());
+
+	const auto removeMs = measureMs(
+	    [&tree, &keys] {
+		    tree.clear();
+		    for (const auto key : keys) {
+			    tree.insert(key, key);
+		    }
+	    },
+	    [&tree, &keys] {
+		    for (const auto key : keys) {
+			    tree.remove(key);
+		    }
+	    });
+
+	report(name + ", remove", removeMs, keys.size());
+}
+
+void updateBenchmark(size_t count) {
+	std::cout << "Insert and remove " << count << " int keys in random order" << std::endl;
+
+	insertRemoveBenchmark<RBST<int, int>>("RBST", count);
+	insertRemoveBenchmark<RBST<int, int, ArenaNodeStorage>>("RBST with ArenaNodeStorage", count);
+	insertRemoveBenchmark<BTree<int, int>>("BTree", count);
+}
+
+template <typename Tree>
+void scanBenchmark(const std::string& name, size_t count, size_t scans, size_t length) {
+	Tree tree;
+	for (const auto key : shuffledKeys(count)) {
+		tree.insert(key, key);
+	}
+
+	const auto starts = randomKeys(scans, count - length);
+	const auto ms = measureMs([&tree, &starts, length] {
+		auto sum = size_t{ 0 };
+		for (const auto start : starts) {
+			auto it = tree.lowerBound(start);
+			for (size_t i = 0; i < length && it != tree.end(); ++i, ++it) {
+				sum += static_cast<size_t>(it->second);
+			}
+		}
+		sink = sink + sum;
+	});
+
+	report(name, ms, scans * length);
+}
+
+void rangeScanBenchmark(size_t count, size_t scans, size_t length) {
+	std::cout << "Range scans of " << length << " elements from random keys, " << count << " int keys" << std::endl;
+
+	scanBenchmark<RBST<int, int>>("RBST", count, scans, length);
+	scanBenchmark<RBST<int, int, ArenaNodeStorage>>("RBST with ArenaNodeStorage", count, scans, length);
+	scanBenchmark<BTree<int, int>>("BTree", count, scans, length);
+}
+
+}
+
+int main(int argc, char** argv) {
+	const auto scale = argc > 1 ? std::stod(argv[1]) : 1.0;
+	const auto scaled = [scale](size_t n) { return std::max<size_t>(static_cast<size_t>(static_cast<double>(n) * scale), 1); };
+	const auto section = std::string(argc > 2 ? argv[2] : "");
+	const auto selected = [&section](const std::string& name) { return section.empty() || section == name; };
+
+	std::cout << "Node search: " << (NodeSearch::vectorized<int, ThreeWayCompare<int>>() ? std::to_string(NodeSearch::vectorBytes * 8) + "-bit vectors" : "binary search") << std::endl;
+
+	if (selected("lookup")) {
+		pointLookupBenchmark({ scaled(10000), scaled(1000000), scaled(10000000) }, scaled(1000000));
+	}
+
+	if (selected("update")) {
+		updateBenchmark(scaled(1000000));
+	}
+
+	if (selected("scan")) {
+		rangeScanBenchmark(scaled(1000000), scaled(10000), 1000);
+	}
+
+	return 0;
+}
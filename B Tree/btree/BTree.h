@@ -0,0 +1,786 @@
+#pragma once
+
+#include "NodeSearch.h"
+
+#include <KeyCompare.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+// B+ tree with the lookup and iteration interface of the binary trees.
+// The keys of a node fill nodeLines cache lines, so a lookup visits O(log_capacity n) nodes instead of paying a
+// cache miss per comparison, and the position within a node is found by NodeSearch. Elements live in the leaves,
+// which are linked in key order so scans run over arrays; inner nodes keep copies of keys as separators.
+// Leaves keep their keys apart from the key-value pairs, so a search never touches the values.
+// Keys are unique. Keys and values must be default constructible, iterators are invalidated by modifications.
+template <typename K, typename V, typename Compare = ThreeWayCompare<K>>
+class BTree {
+public:
+	class NodeIterator;
+
+	using iterator = NodeIterator;
+	using const_iterator = const NodeIterator;
+	using KVPair = std::pair<K, V>;
+	using KeyCompare = Compare;
+
+	BTree() = default;
+	explicit BTree(const Compare& compare);
+	BTree(const BTree& other);
+	BTree(BTree&& other) noexcept;
+	~BTree();
+
+	BTree& operator=(BTree other) noexcept;
+
+	bool contains(const K& key) const;
+
+	iterator find(const K& key) const;
+
+	// Inserts the element unless an element with the key is present, returns whether it did.
+	bool insert(const K& key, const V& value);
+
+	// Assigns value to the element with the key, or inserts it if there is none. Returns whether it inserted.
+	bool insertOrAssign(const K& key, const V& value);
+
+	bool remove(const K& key);
+
+	void clear();
+
+	size_t size() const;
+
+	iterator lowerBound(const K& key) const;
+	iterator upperBound(const K& key) const;
+
+	KeyCompare keyCompare() const;
+
+	iterator begin() const;
+	const_iterator cbegin() const;
+
+	iterator end() const;
+	const_iterator cend() const;
+
+	class NodeIterator final {
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = KVPair;
+		using difference_type = std::ptrdiff_t;
+		using pointer = KVPair*;
+		using reference = KVPair&;
+
+		NodeIterator() = default;
+
+		NodeIterator& operator++();
+		NodeIterator operator++(int);
+
+		NodeIterator& operator--();
+		NodeIterator operator--(int);
+
+		bool operator==(const NodeIterator& other) const;
+		bool operator!=(const NodeIterator& other) const;
+
+		KVPair& operator*();
+		const KVPair& operator*() const;
+
+		KVPair* operator->();
+		const KVPair* operator->() const;
+
+		operator bool() const;
+
+	private:
+		friend class BTree;
+
+		NodeIterator(const BTree* tree, typename BTree::Leaf* leaf, size_t position);
+
+		const BTree* m_tree{ nullptr };
+		typename BTree::Leaf* m_leaf{ nullptr };
+		size_t m_position{ 0 };
+	};
+
+private:
+	static constexpr size_t cacheLine = 64;
+	static constexpr size_t nodeLines = 4;
+
+	// A multiple of the vector width for the key types NodeSearch vectorizes.
+	static constexpr size_t capacity = std::max<size_t>(nodeLines * cacheLine / sizeof(K), 4);
+	static constexpr size_t minCount = capacity / 2;
+
+	struct Node {
+		explicit Node(bool leaf);
+
+		bool m_leaf;
+		uint32_t m_count{ 0 };
+	};
+
+	// Elements with m_keys[i] == m_items[i].first.
+	struct Leaf : Node {
+		Leaf();
+
+		alignas(cacheLine) K m_keys[capacity]{};
+		KVPair m_items[capacity]{};
+		Leaf* m_prev{ nullptr };
+		Leaf* m_next{ nullptr };
+	};
+
+	// m_keys[i] separates m_children[i], whose keys are less, from m_children[i + 1], whose keys are not.
+	struct Inner : Node {
+		Inner();
+
+		alignas(cacheLine) K m_keys[capacity]{};
+		Node* m_children[capacity + 1]{};
+	};
+
+	// Separator and new right sibling of a node split by an insertion.
+	struct Split {
+		K m_key{};
+		Node* m_right{ nullptr };
+	};
+
+	Leaf* findLeaf(const K& key) const;
+
+	bool insert(const K& key, const V& value, bool assign);
+
+	size_t lowerIndex(const Node* node, const K& key) const;
+	size_t upperIndex(const Node* node, const K& key) const;
+
+	// Inserts into the subtree of node, or with assign overwrites the value of an existing element.
+	// Returns whether an element was added, and fills split if node had to be split to make room.
+	bool insert(Node* node, const K& key, const V& value, bool assign, Split& split);
+
+	void insertAt(Leaf* leaf, size_t position, const K& key, const V& value);
+	void insertAt(Inner* inner, size_t position, const K& key, Node* right);
+
+	Leaf* splitLeaf(Leaf* leaf, Split& split);
+	Inner* splitInner(Inner* inner, Split& split);
+
+	// Removes from the subtree of node, the children of node left with fewer than minCount entries are refilled.
+	bool remove(Node* node, const K& key);
+
+	void eraseAt(Leaf* leaf, size_t position);
+	void eraseAt(Inner* inner, size_t position);
+
+	// Refills the child of inner at position from a sibling, or merges it with one.
+	void rebalance(Inner* inner, size_t position);
+	void rebalanceLeaves(Inner* inner, size_t position);
+	void rebalanceInner(Inner* inner, size_t position);
+
+	Node* clone(const Node* node, Leaf*& last);
+	void destroy(Node* node);
+
+	Node* m_root{ nullptr };
+	Leaf* m_first{ nullptr };
+	Leaf* m_last{ nullptr };
+	size_t m_size{ 0 };
+	Compare m_compare{};
+};
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::Node::Node(bool leaf) :
+    m_leaf(leaf)
+{
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::Leaf::Leaf() :
+    Node(true)
+{
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::Inner::Inner() :
+    Node(false)
+{
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::BTree(const Compare& compare) :
+    m_compare(compare)
+{
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::BTree(const BTree& other) :
+    m_size(other.m_size),
+    m_compare(other.m_compare)
+{
+	if (other.m_root) {
+		m_root = clone(other.m_root, m_last);
+	}
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::BTree(BTree&& other) noexcept :
+    m_root(std::exchange(other.m_root, nullptr)),
+    m_first(std::exchange(other.m_first, nullptr)),
+    m_last(std::exchange(other.m_last, nullptr)),
+    m_size(std::exchange(other.m_size, 0)),
+    m_compare(other.m_compare)
+{
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::~BTree() {
+	clear();
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>& BTree<K, V, Compare>::operator=(BTree other) noexcept {
+	std::swap(m_root, other.m_root);
+	std::swap(m_first, other.m_first);
+	std::swap(m_last, other.m_last);
+	std::swap(m_size, other.m_size);
+	std::swap(m_compare, other.m_compare);
+	return *this;
+}
+
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::contains(const K& key) const {
+	return find(key) != end();
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::iterator BTree<K, V, Compare>::find(const K& key) const {
+	const auto leaf = findLeaf(key);
+	if (!leaf) {
+		return end();
+	}
+
+	const auto position = lowerIndex(leaf, key);
+	if (position == leaf->m_count || m_compare(key, leaf->m_keys[position])) {
+		return end();
+	}
+
+	return iterator(this, leaf, position);
+}
+
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::insert(const K& key, const V& value) {
+	return insert(key, value, false);
+}
+
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::insertOrAssign(const K& key, const V& value) {
+	return insert(key, value, true);
+}
+
+// The root may fall below minCount, an inner root left with a single child is replaced by it.
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::remove(const K& key) {
+	if (!m_root || !remove(m_root, key)) {
+		return false;
+	}
+
+	if (m_root->m_leaf && m_root->m_count == 0) {
+		clear();
+	} else if (!m_root->m_leaf && m_root->m_count == 0) {
+		auto root = static_cast<Inner*>(m_root);
+		m_root = root->m_children[0];
+		delete root;
+	}
+
+	return true;
+}
+
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::clear() {
+	if (m_root) {
+		destroy(m_root);
+	}
+
+	m_root = nullptr;
+	m_first = nullptr;
+	m_last = nullptr;
+	m_size = 0;
+}
+
+template <typename K, typename V, typename Compare>
+size_t BTree<K, V, Compare>::size() const {
+	return m_size;
+}
+
+// A separator may outlive the element it was copied from, so the bound can be the first element of the next leaf.
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::iterator BTree<K, V, Compare>::lowerBound(const K& key) const {
+	const auto leaf = findLeaf(key);
+	if (!leaf) {
+		return end();
+	}
+
+	const auto position = lowerIndex(leaf, key);
+	if (position == leaf->m_count) {
+		return iterator(this, leaf->m_next, 0);
+	}
+
+	return iterator(this, leaf, position);
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::iterator BTree<K, V, Compare>::upperBound(const K& key) const {
+	const auto leaf = findLeaf(key);
+	if (!leaf) {
+		return end();
+	}
+
+	const auto position = upperIndex(leaf, key);
+	if (position == leaf->m_count) {
+		return iterator(this, leaf->m_next, 0);
+	}
+
+	return iterator(this, leaf, position);
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::KeyCompare BTree<K, V, Compare>::keyCompare() const {
+	return m_compare;
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::iterator BTree<K, V, Compare>::begin() const {
+	return iterator(this, m_first, 0);
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::const_iterator BTree<K, V, Compare>::cbegin() const {
+	return begin();
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::iterator BTree<K, V, Compare>::end() const {
+	return iterator(this, nullptr, 0);
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::const_iterator BTree<K, V, Compare>::cend() const {
+	return end();
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::NodeIterator::NodeIterator(const BTree* tree, typename BTree::Leaf* leaf, size_t position) :
+    m_tree(tree),
+    m_leaf(leaf),
+    m_position(position)
+{
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::NodeIterator& BTree<K, V, Compare>::NodeIterator::operator++() {
+	if (++m_position == m_leaf->m_count) {
+		m_leaf = m_leaf->m_next;
+		m_position = 0;
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::NodeIterator BTree<K, V, Compare>::NodeIterator::operator++(int) {
+	auto it = *this;
+	++*this;
+	return it;
+}
+
+// Stepping back from end() lands on the last element.
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::NodeIterator& BTree<K, V, Compare>::NodeIterator::operator--() {
+	if (!m_leaf) {
+		m_leaf = m_tree->m_last;
+		m_position = m_leaf->m_count - 1;
+	} else if (m_position == 0) {
+		m_leaf = m_leaf->m_prev;
+		m_position = m_leaf->m_count - 1;
+	} else {
+		--m_position;
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::NodeIterator BTree<K, V, Compare>::NodeIterator::operator--(int) {
+	auto it = *this;
+	--*this;
+	return it;
+}
+
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::NodeIterator::operator==(const NodeIterator& other) const {
+	return m_leaf == other.m_leaf && m_position == other.m_position;
+}
+
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::NodeIterator::operator!=(const NodeIterator& other) const {
+	return !(*this == other);
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::KVPair& BTree<K, V, Compare>::NodeIterator::operator*() {
+	return m_leaf->m_items[m_position];
+}
+
+template <typename K, typename V, typename Compare>
+const typename BTree<K, V, Compare>::KVPair& BTree<K, V, Compare>::NodeIterator::operator*() const {
+	return m_leaf->m_items[m_position];
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::KVPair* BTree<K, V, Compare>::NodeIterator::operator->() {
+	return &m_leaf->m_items[m_position];
+}
+
+template <typename K, typename V, typename Compare>
+const typename BTree<K, V, Compare>::KVPair* BTree<K, V, Compare>::NodeIterator::operator->() const {
+	return &m_leaf->m_items[m_position];
+}
+
+template <typename K, typename V, typename Compare>
+BTree<K, V, Compare>::NodeIterator::operator bool() const {
+	return m_leaf != nullptr;
+}
+
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::Leaf* BTree<K, V, Compare>::findLeaf(const K& key) const {
+	auto node = m_root;
+	if (!node) {
+		return nullptr;
+	}
+
+	while (!node->m_leaf) {
+		const auto inner = static_cast<const Inner*>(node);
+		node = inner->m_children[upperIndex(inner, key)];
+	}
+
+	return static_cast<Leaf*>(node);
+}
+
+template <typename K, typename V, typename Compare>
+size_t BTree<K, V, Compare>::lowerIndex(const Node* node, const K& key) const {
+	const auto keys = node->m_leaf ? static_cast<const Leaf*>(node)->m_keys : static_cast<const Inner*>(node)->m_keys;
+	return NodeSearch::countLess(keys, node->m_count, key, m_compare);
+}
+
+template <typename K, typename V, typename Compare>
+size_t BTree<K, V, Compare>::upperIndex(const Node* node, const K& key) const {
+	const auto keys = node->m_leaf ? static_cast<const Leaf*>(node)->m_keys : static_cast<const Inner*>(node)->m_keys;
+	return NodeSearch::countNotGreater(keys, node->m_count, key, m_compare);
+}
+
+// A split root gets a new root above it, so all leaves stay at the same depth.
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::insert(const K& key, const V& value, bool assign) {
+	if (!m_root) {
+		m_root = m_first = m_last = new Leaf();
+	}
+
+	Split split;
+	const auto inserted = insert(m_root, key, value, assign, split);
+
+	if (split.m_right) {
+		auto root = new Inner();
+		root->m_keys[0] = std::move(split.m_key);
+		root->m_children[0] = m_root;
+		root->m_children[1] = split.m_right;
+		root->m_count = 1;
+		m_root = root;
+	}
+
+	return inserted;
+}
+
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::insert(Node* node, const K& key, const V& value, bool assign, Split& split) {
+	if (node->m_leaf) {
+		auto leaf = static_cast<Leaf*>(node);
+		auto position = lowerIndex(leaf, key);
+
+		if (position < leaf->m_count && !m_compare(key, leaf->m_keys[position])) {
+			if (assign) {
+				leaf->m_items[position].second = value;
+			}
+
+			return false;
+		}
+
+		if (leaf->m_count == capacity) {
+			auto right = splitLeaf(leaf, split);
+			if (position > leaf->m_count) {
+				position -= leaf->m_count;
+				leaf = right;
+			}
+		}
+
+		insertAt(leaf, position, key, value);
+		++m_size;
+		return true;
+	}
+
+	auto inner = static_cast<Inner*>(node);
+	const auto position = upperIndex(inner, key);
+
+	Split childSplit;
+	const auto inserted = insert(inner->m_children[position], key, value, assign, childSplit);
+
+	if (childSplit.m_right) {
+		if (inner->m_count == capacity) {
+			auto right = splitInner(inner, split);
+			if (position > inner->m_count) {
+				insertAt(right, position - inner->m_count - 1, std::move(childSplit.m_key), childSplit.m_right);
+				return inserted;
+			}
+		}
+
+		insertAt(inner, position, std::move(childSplit.m_key), childSplit.m_right);
+	}
+
+	return inserted;
+}
+
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::insertAt(Leaf* leaf, size_t position, const K& key, const V& value) {
+	std::move_backward(leaf->m_keys + position, leaf->m_keys + leaf->m_count, leaf->m_keys + leaf->m_count + 1);
+	std::move_backward(leaf->m_items + position, leaf->m_items + leaf->m_count, leaf->m_items + leaf->m_count + 1);
+	leaf->m_keys[position] = key;
+	leaf->m_items[position] = KVPair(key, value);
+	++leaf->m_count;
+}
+
+// The separator goes before position, the node right of it after.
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::insertAt(Inner* inner, size_t position, const K& key, Node* right) {
+	std::move_backward(inner->m_keys + position, inner->m_keys + inner->m_count, inner->m_keys + inner->m_count + 1);
+	std::move_backward(inner->m_children + position + 1, inner->m_children + inner->m_count + 1, inner->m_children + inner->m_count + 2);
+	inner->m_keys[position] = key;
+	inner->m_children[position + 1] = right;
+	++inner->m_count;
+}
+
+// Moves the upper half of a full leaf into a new leaf linked after it. An insertion at the split point stays
+// in the left leaf, so the separator remains the first key of the right one.
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::Leaf* BTree<K, V, Compare>::splitLeaf(Leaf* leaf, Split& split) {
+	auto right = new Leaf();
+
+	std::move(leaf->m_keys + minCount, leaf->m_keys + capacity, right->m_keys);
+	std::move(leaf->m_items + minCount, leaf->m_items + capacity, right->m_items);
+	right->m_count = static_cast<uint32_t>(capacity - minCount);
+	leaf->m_count = static_cast<uint32_t>(minCount);
+
+	right->m_prev = leaf;
+	right->m_next = leaf->m_next;
+	if (leaf->m_next) {
+		leaf->m_next->m_prev = right;
+	} else {
+		m_last = right;
+	}
+	leaf->m_next = right;
+
+	split.m_key = right->m_keys[0];
+	split.m_right = right;
+	return right;
+}
+
+// The middle key of a full inner node moves up as the separator of the two halves.
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::Inner* BTree<K, V, Compare>::splitInner(Inner* inner, Split& split) {
+	auto right = new Inner();
+
+	std::move(inner->m_keys + minCount + 1, inner->m_keys + capacity, right->m_keys);
+	std::copy(inner->m_children + minCount + 1, inner->m_children + capacity + 1, right->m_children);
+	right->m_count = static_cast<uint32_t>(capacity - minCount - 1);
+	inner->m_count = static_cast<uint32_t>(minCount);
+
+	split.m_key = std::move(inner->m_keys[minCount]);
+	split.m_right = right;
+	return right;
+}
+
+template <typename K, typename V, typename Compare>
+bool BTree<K, V, Compare>::remove(Node* node, const K& key) {
+	if (node->m_leaf) {
+		auto leaf = static_cast<Leaf*>(node);
+		const auto position = lowerIndex(leaf, key);
+
+		if (position == leaf->m_count || m_compare(key, leaf->m_keys[position])) {
+			return false;
+		}
+
+		eraseAt(leaf, position);
+		--m_size;
+		return true;
+	}
+
+	auto inner = static_cast<Inner*>(node);
+	const auto position = upperIndex(inner, key);
+
+	if (!remove(inner->m_children[position], key)) {
+		return false;
+	}
+
+	if (inner->m_children[position]->m_count < minCount) {
+		rebalance(inner, position);
+	}
+
+	return true;
+}
+
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::eraseAt(Leaf* leaf, size_t position) {
+	std::move(leaf->m_keys + position + 1, leaf->m_keys + leaf->m_count, leaf->m_keys + position);
+	std::move(leaf->m_items + position + 1, leaf->m_items + leaf->m_count, leaf->m_items + position);
+	--leaf->m_count;
+}
+
+// Removes the separator at position and the child right of it.
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::eraseAt(Inner* inner, size_t position) {
+	std::move(inner->m_keys + position + 1, inner->m_keys + inner->m_count, inner->m_keys + position);
+	std::copy(inner->m_children + position + 2, inner->m_children + inner->m_count + 1, inner->m_children + position + 1);
+	--inner->m_count;
+}
+
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::rebalance(Inner* inner, size_t position) {
+	if (inner->m_children[position]->m_leaf) {
+		rebalanceLeaves(inner, position);
+	} else {
+		rebalanceInner(inner, position);
+	}
+}
+
+// Takes an element from a sibling with more than minCount, otherwise merges with one. Merged nodes hold
+// minCount - 1 + minCount elements, which fit.
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::rebalanceLeaves(Inner* inner, size_t position) {
+	auto leaf = static_cast<Leaf*>(inner->m_children[position]);
+	auto left = position > 0 ? static_cast<Leaf*>(inner->m_children[position - 1]) : nullptr;
+	auto right = position < inner->m_count ? static_cast<Leaf*>(inner->m_children[position + 1]) : nullptr;
+
+	if (left && left->m_count > minCount) {
+		std::move_backward(leaf->m_keys, leaf->m_keys + leaf->m_count, leaf->m_keys + leaf->m_count + 1);
+		std::move_backward(leaf->m_items, leaf->m_items + leaf->m_count, leaf->m_items + leaf->m_count + 1);
+		--left->m_count;
+		leaf->m_keys[0] = std::move(left->m_keys[left->m_count]);
+		leaf->m_items[0] = std::move(left->m_items[left->m_count]);
+		++leaf->m_count;
+		inner->m_keys[position - 1] = leaf->m_keys[0];
+		return;
+	}
+
+	if (right && right->m_count > minCount) {
+		leaf->m_keys[leaf->m_count] = std::move(right->m_keys[0]);
+		leaf->m_items[leaf->m_count] = std::move(right->m_items[0]);
+		++leaf->m_count;
+		eraseAt(right, 0);
+		inner->m_keys[position] = right->m_keys[0];
+		return;
+	}
+
+	if (!left) {
+		left = leaf;
+		leaf = right;
+		++position;
+	}
+
+	std::move(leaf->m_keys, leaf->m_keys + leaf->m_count, left->m_keys + left->m_count);
+	std::move(leaf->m_items, leaf->m_items + leaf->m_count, left->m_items + left->m_count);
+	left->m_count += leaf->m_count;
+
+	left->m_next = leaf->m_next;
+	if (leaf->m_next) {
+		leaf->m_next->m_prev = left;
+	} else {
+		m_last = left;
+	}
+
+	eraseAt(inner, position - 1);
+	delete leaf;
+}
+
+// As for leaves, but keys rotate through the separator in inner, and a merge pulls the separator down.
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::rebalanceInner(Inner* inner, size_t position) {
+	auto node = static_cast<Inner*>(inner->m_children[position]);
+	auto left = position > 0 ? static_cast<Inner*>(inner->m_children[position - 1]) : nullptr;
+	auto right = position < inner->m_count ? static_cast<Inner*>(inner->m_children[position + 1]) : nullptr;
+
+	if (left && left->m_count > minCount) {
+		std::move_backward(node->m_keys, node->m_keys + node->m_count, node->m_keys + node->m_count + 1);
+		std::move_backward(node->m_children, node->m_children + node->m_count + 1, node->m_children + node->m_count + 2);
+		node->m_keys[0] = std::move(inner->m_keys[position - 1]);
+		node->m_children[0] = left->m_children[left->m_count];
+		++node->m_count;
+		inner->m_keys[position - 1] = std::move(left->m_keys[left->m_count - 1]);
+		--left->m_count;
+		return;
+	}
+
+	if (right && right->m_count > minCount) {
+		node->m_keys[node->m_count] = std::move(inner->m_keys[position]);
+		node->m_children[node->m_count + 1] = right->m_children[0];
+		++node->m_count;
+		inner->m_keys[position] = std::move(right->m_keys[0]);
+		std::move(right->m_keys + 1, right->m_keys + right->m_count, right->m_keys);
+		std::copy(right->m_children + 1, right->m_children + right->m_count + 1, right->m_children);
+		--right->m_count;
+		return;
+	}
+
+	if (!left) {
+		left = node;
+		node = right;
+		++position;
+	}
+
+	left->m_keys[left->m_count] = std::move(inner->m_keys[position - 1]);
+	std::move(node->m_keys, node->m_keys + node->m_count, left->m_keys + left->m_count + 1);
+	std::copy(node->m_children, node->m_children + node->m_count + 1, left->m_children + left->m_count + 1);
+	left->m_count += node->m_count + 1;
+
+	eraseAt(inner, position - 1);
+	delete node;
+}
+
+// Copies the subtree of node, linking the copied leaves after last.
+template <typename K, typename V, typename Compare>
+typename BTree<K, V, Compare>::Node* BTree<K, V, Compare>::clone(const Node* node, Leaf*& last) {
+	if (node->m_leaf) {
+		auto leaf = new Leaf(*static_cast<const Leaf*>(node));
+		leaf->m_prev = last;
+		leaf->m_next = nullptr;
+		if (last) {
+			last->m_next = leaf;
+		} else {
+			m_first = leaf;
+		}
+
+		last = leaf;
+		return leaf;
+	}
+
+	const auto original = static_cast<const Inner*>(node);
+	auto inner = new Inner();
+	std::copy(original->m_keys, original->m_keys + original->m_count, inner->m_keys);
+	inner->m_count = original->m_count;
+
+	for (size_t i = 0; i <= original->m_count; ++i) {
+		inner->m_children[i] = clone(original->m_children[i], last);
+	}
+
+	return inner;
+}
+
+template <typename K, typename V, typename Compare>
+void BTree<K, V, Compare>::destroy(Node* node) {
+	if (node->m_leaf) {
+		delete static_cast<Leaf*>(node);
+		return;
+	}
+
+	auto inner = static_cast<Inner*>(node);
+	for (size_t i = 0; i <= inner->m_count; ++i) {
+		destroy(inner->m_children[i]);
+	}
+
+	delete inner;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <KeyCompare.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Vector width of the node search, from the instruction set the build targets. Defining BTREE_SCALAR_SEARCH
+// turns it off. 64-bit integer keys need SSE4.2 on the 128-bit path, the other key types only SSE2.
+#if !defined(BTREE_SCALAR_SEARCH) && defined(__AVX2__)
+#define BTREE_AVX2_SEARCH
+#include <immintrin.h>
+#elif !defined(BTREE_SCALAR_SEARCH) && (defined(__SSE2__) || defined(_M_X64))
+#define BTREE_SSE_SEARCH
+#include <emmintrin.h>
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+#endif
+
+// Position of a key among the sorted keys of a B-tree node.
+// With the default ordering, 32 and 64-bit signed integer and floating-point keys are compared a vector at a time
+// and the lanes that compare less are counted, without branches on the keys. Other keys use a binary search.
+// Vector searches read keys up to count rounded up to the vector width, nodes provide that much padding.
+class NodeSearch {
+public:
+	// Number of keys less than key.
+	template <typename K, typename Compare>
+	static size_t countLess(const K* keys, size_t count, const K& key, const Compare& compare);
+
+	// Number of keys not greater than key.
+	template <typename K, typename Compare>
+	static size_t countNotGreater(const K* keys, size_t count, const K& key, const Compare& compare);
+
+#if defined(BTREE_AVX2_SEARCH)
+	static constexpr size_t vectorBytes = 32;
+#elif defined(BTREE_SSE_SEARCH)
+	static constexpr size_t vectorBytes = 16;
+#else
+	static constexpr size_t vectorBytes = 0;
+#endif
+
+	// Whether keys of type K compared by Compare take the vector search.
+	template <typename K, typename Compare>
+	static constexpr bool vectorized();
+
+private:
+	// The vector lane type holding a key.
+	template <typename K>
+	using Lane = std::conditional_t<std::is_floating_point<K>::value, K, std::conditional_t<sizeof(K) == 4, int32_t, int64_t>>;
+
+	template <bool notGreater, typename T>
+	static size_t countVector(const T* keys, size_t count, T key);
+
+#if defined(BTREE_AVX2_SEARCH) || defined(BTREE_SSE_SEARCH)
+	// One bit per lane of the vector at keys, set where the lane is less or greater than key.
+	static unsigned lessMask(const int32_t* keys, int32_t key);
+	static unsigned lessMask(const int64_t* keys, int64_t key);
+	static unsigned lessMask(const float* keys, float key);
+	static unsigned lessMask(const double* keys, double key);
+
+	static unsigned greaterMask(const int32_t* keys, int32_t key);
+	static unsigned greaterMask(const int64_t* keys, int64_t key);
+	static unsigned greaterMask(const float* keys, float key);
+	static unsigned greaterMask(const double* keys, double key);
+#endif
+
+	// Masks have at most 8 bits.
+	static unsigned bitCount(unsigned mask);
+};
+
+template <typename K, typename Compare>
+size_t NodeSearch::countLess(const K* keys, size_t count, const K& key, const Compare& compare) {
+	if constexpr (vectorized<K, Compare>()) {
+		return countVector<false>(reinterpret_cast<const Lane<K>*>(keys), count, static_cast<Lane<K>>(key));
+	} else {
+		return static_cast<size_t>(std::partition_point(keys, keys + count, [&compare, &key](const K& item) {
+			return compare(item, key);
+		}) - keys);
+	}
+}
+
+template <typename K, typename Compare>
+size_t NodeSearch::countNotGreater(const K* keys, size_t count, const K& key, const Compare& compare) {
+	if constexpr (vectorized<K, Compare>()) {
+		return countVector<true>(reinterpret_cast<const Lane<K>*>(keys), count, static_cast<Lane<K>>(key));
+	} else {
+		return static_cast<size_t>(std::partition_point(keys, keys + count, [&compare, &key](const K& item) {
+			return !compare(key, item);
+		}) - keys);
+	}
+}
+
+template <typename K, typename Compare>
+constexpr bool NodeSearch::vectorized() {
+	if constexpr (vectorBytes == 0 || !(std::is_same<Compare, ThreeWayCompare<K>>::value || std::is_same<Compare, ThreeWayCompare<>>::value)) {
+		return false;
+	} else if constexpr (std::is_floating_point<K>::value) {
+		return std::is_same<K, float>::value || std::is_same<K, double>::value;
+	} else if constexpr (std::is_integral<K>::value && std::is_signed<K>::value && sizeof(K) == 4) {
+		return true;
+	} else if constexpr (std::is_integral<K>::value && std::is_signed<K>::value && sizeof(K) == 8) {
+#if defined(BTREE_SSE_SEARCH) && !defined(__SSE4_2__)
+		return false;
+#else
+		return true;
+#endif
+	} else {
+		return false;
+	}
+}
+
+// Counts the lanes comparing less, or greater for notGreater, the lanes past count are masked off.
+template <bool notGreater, typename T>
+size_t NodeSearch::countVector(const T* keys, size_t count, T key) {
+#if defined(BTREE_AVX2_SEARCH) || defined(BTREE_SSE_SEARCH)
+	constexpr auto lanes = vectorBytes / sizeof(T);
+
+	auto counted = size_t{ 0 };
+	for (size_t i = 0; i < count; i += lanes) {
+		auto mask = notGreater ? greaterMask(keys + i, key) : lessMask(keys + i, key);
+		if (count - i < lanes) {
+			mask &= (1u << (count - i)) - 1;
+		}
+
+		counted += bitCount(mask);
+	}
+
+	return notGreater ? count - counted : counted;
+#else
+	(void)keys;
+	(void)key;
+	return count;
+#endif
+}
+
+#if defined(BTREE_AVX2_SEARCH)
+
+inline unsigned NodeSearch::lessMask(const int32_t* keys, int32_t key) {
+	const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+	return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(key), block))));
+}
+
+inline unsigned NodeSearch::lessMask(const int64_t* keys, int64_t key) {
+	const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+	return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(key), block))));
+}
+
+inline unsigned NodeSearch::lessMask(const float* keys, float key) {
+	return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(keys), _mm256_set1_ps(key), _CMP_LT_OQ)));
+}
+
+inline unsigned NodeSearch::lessMask(const double* keys, double key) {
+	return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(keys), _mm256_set1_pd(key), _CMP_LT_OQ)));
+}
+
+inline unsigned NodeSearch::greaterMask(const int32_t* keys, int32_t key) {
+	const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+	return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(block, _mm256_set1_epi32(key)))));
+}
+
+inline unsigned NodeSearch::greaterMask(const int64_t* keys, int64_t key) {
+	const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+	return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(block, _mm256_set1_epi64x(key)))));
+}
+
+inline unsigned NodeSearch::greaterMask(const float* keys, float key) {
+	return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(keys), _mm256_set1_ps(key), _CMP_GT_OQ)));
+}
+
+inline unsigned NodeSearch::greaterMask(const double* keys, double key) {
+	return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(keys), _mm256_set1_pd(key), _CMP_GT_OQ)));
+}
+
+#elif defined(BTREE_SSE_SEARCH)
+
+inline unsigned NodeSearch::lessMask(const int32_t* keys, int32_t key) {
+	const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+	return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(key), block))));
+}
+
+inline unsigned NodeSearch::lessMask(const float* keys, float key) {
+	return static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(keys), _mm_set1_ps(key))));
+}
+
+inline unsigned NodeSearch::lessMask(const double* keys, double key) {
+	return static_cast<unsigned>(_mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(keys), _mm_set1_pd(key))));
+}
+
+inline unsigned NodeSearch::greaterMask(const int32_t* keys, int32_t key) {
+	const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+	return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, _mm_set1_epi32(key)))));
+}
+
+inline unsigned NodeSearch::greaterMask(const float* keys, float key) {
+	return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(keys), _mm_set1_ps(key))));
+}
+
+inline unsigned NodeSearch::greaterMask(const double* keys, double key) {
+	return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(keys), _mm_set1_pd(key))));
+}
+
+#if defined(__SSE4_2__)
+inline unsigned NodeSearch::lessMask(const int64_t* keys, int64_t key) {
+	const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+	return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(_mm_set1_epi64x(key), block))));
+}
+
+inline unsigned NodeSearch::greaterMask(const int64_t* keys, int64_t key) {
+	const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+	return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(block, _mm_set1_epi64x(key)))));
+}
+#endif
+
+#endif
+
+inline unsigned NodeSearch::bitCount(unsigned mask) {
+	static constexpr unsigned char nibbleBits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+	return nibbleBits[mask & 15] + nibbleBits[(mask >> 4) & 15];
+}
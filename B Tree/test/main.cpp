@@ -0,0 +1,186 @@
+#include "BTree.h"
+
+#include <FrozenTree.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checks a tree against std::map under random inserts and removes of keys made from small integers.
+template <typename K, typename Compare, typename MakeKey>
+void randomizedTest(MakeKey makeKey, size_t operations, size_t keyRange) {
+	BTree<K, int, Compare> tree;
+	std::map<K, int, Compare> expected;
+	std::mt19937 random(11);
+
+	for (size_t step = 0; step < operations; ++step) {
+		const auto key = makeKey(random() % keyRange);
+
+		if (random() % 3 != 0) {
+			const auto inserted = tree.insert(key, static_cast<int>(step));
+			const auto expectedInserted = expected.emplace(key, static_cast<int>(step)).second;
+			assert(inserted == expectedInserted);
+		} else {
+			const auto removed = tree.remove(key);
+			const auto expectedRemoved = expected.erase(key) != 0;
+			assert(removed == expectedRemoved);
+		}
+	}
+
+	assert(tree.size() == expected.size());
+	assert(std::equal(tree.begin(), tree.end(), expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.first == rhs.first && lhs.second == rhs.second;
+	}));
+
+	for (size_t i = 0; i <= keyRange; ++i) {
+		const auto key = makeKey(i);
+		const auto lower = expected.lower_bound(key);
+		const auto upper = expected.upper_bound(key);
+
+		assert(tree.contains(key) == (expected.count(key) != 0));
+		assert(lower == expected.end() ? !tree.lowerBound(key) : tree.lowerBound(key)->first == lower->first);
+		assert(upper == expected.end() ? !tree.upperBound(key) : tree.upperBound(key)->first == upper->first);
+	}
+
+	for (auto it = expected.begin(); it != expected.end(); it = expected.erase(it)) {
+		const auto removed = tree.remove(it->first);
+		assert(removed);
+	}
+
+	assert(tree.size() == 0 && tree.begin() == tree.end());
+}
+
+int main() {
+	BTree<int, std::string> tree;
+
+	/* insertion */
+
+	for (auto i = 0; i < 10000; ++i) {
+		const auto inserted = tree.insert(i, std::to_string(i));
+		assert(inserted);
+	}
+
+	const auto insertedTwice = tree.insert(5, "five");
+	assert(!insertedTwice);
+	assert(tree.size() == 10000);
+
+	for (auto i = 0; i < 10000; ++i) {
+		assert(tree.find(i)->second == std::to_string(i));
+	}
+
+	assert(tree.find(10000) == tree.end() && !tree.contains(-1));
+
+	std::cout << "Insertion OK" << std::endl;
+
+	/* removal */
+
+	for (auto i = 0; i < 10000; i += 2) {
+		const auto removed = tree.remove(i);
+		assert(removed);
+	}
+
+	const auto removedTwice = tree.remove(0);
+	assert(!removedTwice);
+	assert(tree.size() == 5000);
+
+	for (auto i = 0; i < 10000; ++i) {
+		assert(tree.contains(i) == (i % 2 != 0));
+	}
+
+	std::cout << "Removal OK" << std::endl;
+
+	/* insert or assign */
+
+	const auto assignedOne = tree.insertOrAssign(1, "one");
+	const auto assignedTwo = tree.insertOrAssign(2, "two");
+	assert(!assignedOne && assignedTwo);
+	assert(tree.find(1)->second == "one" && tree.find(2)->second == "two" && tree.size() == 5001);
+
+	std::cout << "Insert or assign OK" << std::endl;
+
+	/* iterators */
+
+	std::vector<int> keys;
+	for (const auto& item : tree) {
+		keys.push_back(item.first);
+	}
+
+	assert(keys.size() == 5001 && std::is_sorted(keys.begin(), keys.end()) && keys.back() == 9999);
+
+	auto backIt = tree.end();
+	while (!keys.empty()) {
+		--backIt;
+		assert(backIt->first == keys.back());
+		keys.pop_back();
+	}
+
+	assert(backIt == tree.begin());
+
+	std::cout << "Iterators OK" << std::endl;
+
+	/* bounds */
+
+	assert(tree.lowerBound(4)->first == 5 && tree.lowerBound(5)->first == 5);
+	assert(tree.upperBound(5)->first == 7 && tree.upperBound(-10)->first == 1);
+	assert(tree.lowerBound(10000) == tree.end() && tree.upperBound(9999) == tree.end());
+
+	auto scanned = 0;
+	for (auto it = tree.lowerBound(100); it != tree.upperBound(200); ++it) {
+		++scanned;
+	}
+
+	assert(scanned == 50);
+
+	std::cout << "Bounds OK" << std::endl;
+
+	/* copy and move */
+
+	auto copied = tree;
+	copied.remove(1);
+	assert(copied.size() == 5000 && tree.size() == 5001 && tree.contains(1));
+	assert(std::equal(std::next(tree.begin()), tree.end(), copied.begin()));
+
+	auto moved = std::move(copied);
+	auto movedLast = moved.end();
+	--movedLast;
+	assert(moved.size() == 5000 && movedLast->first == 9999);
+
+	tree.clear();
+	assert(tree.size() == 0 && tree.begin() == tree.end() && !tree.contains(1));
+
+	std::cout << "Copy and move OK" << std::endl;
+
+	/* key types */
+
+	// Vectorized node searches for 32 and 64-bit integers and floating point, binary searches for the others.
+	randomizedTest<int, ThreeWayCompare<int>>([](size_t i) { return static_cast<int>(i) - 5000; }, 100000, 20000);
+	randomizedTest<int64_t, ThreeWayCompare<int64_t>>([](size_t i) { return static_cast<int64_t>(i) * 3000000000 - 7; }, 50000, 10000);
+	randomizedTest<float, ThreeWayCompare<float>>([](size_t i) { return static_cast<float>(i) * 0.5f - 100.0f; }, 50000, 10000);
+	randomizedTest<double, ThreeWayCompare<double>>([](size_t i) { return static_cast<double>(i) / 3; }, 50000, 10000);
+	randomizedTest<unsigned, ThreeWayCompare<unsigned>>([](size_t i) { return static_cast<unsigned>(i); }, 50000, 10000);
+	randomizedTest<int, std::greater<int>>([](size_t i) { return static_cast<int>(i); }, 50000, 10000);
+	randomizedTest<std::string, ThreeWayCompare<std::string>>([](size_t i) { return std::to_string(i); }, 50000, 10000);
+
+	std::cout << "Key types OK" << std::endl;
+
+	/* freezing */
+
+	BTree<int, int> unfrozenTree;
+	for (auto i = 0; i < 1000; ++i) {
+		unfrozenTree.insert(3 * i, i);
+	}
+
+	const auto frozenTree = freeze(unfrozenTree);
+	assert(frozenTree.size() == 1000 && std::equal(frozenTree.begin(), frozenTree.end(), unfrozenTree.begin()));
+	assert(frozenTree.rank(30) == 10);
+
+	std::cout << "Freezing OK" << std::endl;
+
+	return 0;
+}
@@ -287,36 +287,8 @@ std::string EBST::toString(const NodeRule rule) const {
 	return {};
 }
 
-// unused stuff
-
-void EBST::insert(const ExpressionNode&, const bool &) {}
-
-EBST::NodePtr EBST::insert(EBST::NodePtr&, const AbstractBST::KVPair&) {
-    return EBST::NodePtr();
-}
-
-bool EBST::remove(const ExpressionNode&) {
-    return false;
-}
-
-EBST::NodePtr EBST::remove(EBST::NodePtr&, const ExpressionNode&) {
-    return EBST::NodePtr();
-}
-
 EBST::NodePtr EBST::find(const EBST::NodePtr&, const ExpressionNode&) const {
 	return EBST::NodePtr();
 }
 
-EBST::iterator EBST::find(const ExpressionNode&) const {
-	return iterator();
-}
-
-EBST::iterator EBST::begin() const {
-	return AbstractBaseTree::begin();
-}
-
 EBST::Node::Node(const KVPair& keyValue) : AbstractNode(keyValue) {}
-
-EBST::NodePtr EBST::Node::next() const {
-    return NodePtr();
-}
@@ -17,9 +17,9 @@ struct ExpressionSolution {
 	std::optional<double> discriminant;
 };
 
-class EBST final : public AbstractBST<ExpressionNode, bool> {
+class EBST final : public AbstractBST<EBST, ExpressionNode, bool> {
 public:
-	using AbstractBaseTree = AbstractBST<ExpressionNode, bool>;
+	using AbstractBaseTree = AbstractBST<EBST, ExpressionNode, bool>;
 	using AbstractBaseTree::find;
 
 	enum class OutputType {
@@ -39,10 +39,10 @@ public:
 	ExpressionSolution solution() const;
 
 private:
+	friend AbstractBaseTree;
+
 	struct Node final : public AbstractBaseTree::AbstractNode {
 		Node(const typename AbstractBaseTree::KVPair& keyValue);
-
-		typename AbstractBaseTree::AbstractNode::Ptr next() const override;
 	};
 	using NodePtr = typename Node::Ptr;
 
@@ -161,12 +161,6 @@ private:
 	bool m_isBalanced = false;
 	std::string m_unknownOperandName = {invalidOperandVarName};
 
-	// unused stuff
-    void insert(const ExpressionNode& key, const bool&) override;
-    NodePtr insert(NodePtr& node, const typename AbstractBaseTree::KVPair& keyValue) override;
-    bool remove(const ExpressionNode& key) override;
-	NodePtr remove(NodePtr &p, const ExpressionNode &key) override;
-	NodePtr find(const NodePtr& node, const ExpressionNode& key) const override;
-	iterator find(const ExpressionNode& key) const override;
-	iterator begin() const override;
+	// expressions are not looked up by key, find and contains always miss
+	NodePtr find(const NodePtr& node, const ExpressionNode& key) const;
 };
@@ -0,0 +1,1114 @@
+#include "RBST.h"
+#include "CompactRBST.h"
+#include "PersistentRBST.h"
+#include "RcuRBST.h"
+#include "ConcurrentRBST.h"
+#include "ShardedRBST.h"
+
+#include <AnyBST.h>
+#include <FrozenTree.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const auto repetitions = 3;
+
+// Results are accumulated here so the optimizer cannot drop the measured work.
+volatile size_t sink = 0;
+
+template <typename F>
+double measureMs(F&& fn) {
+	auto best = std::numeric_limits<double>::max();
+
+	for (auto r = 0; r < repetitions; ++r) {
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	return best;
+}
+
+// Runs setup before every repetition and measures fn only.
+template <typename S, typename F>
+double measureMs(S&& setup, F&& fn) {
+	auto best = std::numeric_limits<double>::max();
+
+	for (auto r = 0; r < repetitions; ++r) {
+		setup();
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	return best;
+}
+
+// Thread counts doubling from 1, ending with maxThreads itself when it is not a power of two.
+std::vector<size_t> threadCounts(size_t maxThreads) {
+	std::vector<size_t> counts;
+	for (size_t threads = 1; threads < maxThreads; threads *= 2) {
+		counts.push_back(threads);
+	}
+
+	counts.push_back(maxThreads);
+	return counts;
+}
+
+void report(const std::string& name, double ms, size_t operations = 0) {
+	std::cout << "  " << std::left << std::setw(52) << name << std::right << std::setw(12) << std::fixed << std::setprecision(2) << ms << " ms";
+
+	if (operations > 0) {
+		std::cout << std::setw(12) << ms * 1e6 / static_cast<double>(operations) << " ns/op";
+	}
+
+	std::cout << std::endl;
+}
+
+template <typename Tree>
+void insertWorkload(size_t count) {
+	Tree tree;
+
+	for (size_t i = 0; i < count; ++i) {
+		tree.insert(static_cast<int>(i), std::to_string(i));
+	}
+}
+
+void storageBenchmark(size_t count) {
+	std::cout << "Insert " << count << " keys into RBST<int, std::string>" << std::endl;
+
+	report("SharedNodeStorage", measureMs([count] { insertWorkload<RBST<int, std::string>>(count); }));
+	report("ArenaNodeStorage", measureMs([count] { insertWorkload<RBST<int, std::string, ArenaNodeStorage>>(count); }));
+}
+
+
+template <typename Tree>
+void lookupBenchmark(const std::string& name, Tree& tree, size_t count, size_t lookups = 0) {
+	for (size_t i = 0; i < count; ++i) {
+		tree.insert(static_cast<int>(i), static_cast<int>(i));
+	}
+
+	std::mt19937 rng(42);
+	std::vector<int> keys(lookups > 0 ? lookups : count);
+	for (auto& key : keys) {
+		key = static_cast<int>(rng() % count);
+	}
+
+	const auto ms = measureMs([&tree, &keys] {
+		auto found = size_t{ 0 };
+		for (const auto key : keys) {
+			found += tree.contains(key) ? 1 : 0;
+		}
+		sink = sink + found;
+	});
+
+	report(name, ms, keys.size());
+}
+
+template <typename Tree>
+void lookupBenchmark(const std::string& name, size_t count, size_t lookups = 0) {
+	Tree tree;
+	lookupBenchmark(name, tree, count, lookups);
+}
+
+void layoutBenchmark(size_t count) {
+	std::cout << "Look up " << count << " random keys in RBST<int, int>" << std::endl;
+
+	lookupBenchmark<RBST<int, int>>("RBST", count);
+	lookupBenchmark<RBST<int, int, ArenaNodeStorage>>("RBST, ArenaNodeStorage", count);
+	lookupBenchmark<CompactRBST<int, int>>("CompactRBST", count);
+}
+
+void lookupLatencyBenchmark(const std::vector<size_t>& sizes, size_t lookups) {
+	std::cout << "Lookup latency, " << lookups << " random lookups in RBST<int, int>" << std::endl;
+
+	for (const auto count : sizes) {
+		lookupBenchmark<RBST<int, int>>(std::to_string(count) + " keys", count, lookups);
+		lookupBenchmark<RBST<int, int, ArenaNodeStorage>>(std::to_string(count) + " keys, ArenaNodeStorage", count, lookups);
+	}
+}
+
+// Lookups of random keys in count even keys, so half of them miss. The pointer trees are skipped above pointerTreeLimit keys,
+// where their nodes would not fit in memory next to the arrays.
+void frozenLookupBenchmark(const std::string& name, size_t count, size_t lookups, size_t pointerTreeLimit) {
+	std::vector<std::pair<int, int>> items;
+	std::vector<int> sortedKeys;
+	for (size_t i = 0; i < count; ++i) {
+		items.emplace_back(static_cast<int>(2 * i), static_cast<int>(i));
+		sortedKeys.push_back(static_cast<int>(2 * i));
+	}
+
+	std::mt19937 random(23);
+	std::vector<int> keys(lookups);
+	for (auto& key : keys) {
+		key = static_cast<int>(random() % (2 * count));
+	}
+
+	const auto lookup = [&keys](auto&& contains) {
+		return measureMs([&] {
+			auto found = size_t{ 0 };
+			for (const auto key : keys) {
+				found += contains(key) ? 1 : 0;
+			}
+			sink = sink + found;
+		});
+	};
+
+	std::cout << "  " << name << ", " << count << " keys" << std::endl;
+
+	if (count <= pointerTreeLimit) {
+		RBST<int, int> tree;
+		tree.assignSorted(items.cbegin(), items.cend());
+		report("RBST find", lookup([&tree](int key) { return tree.contains(key); }), lookups);
+
+		RBST<int, int, ArenaNodeStorage> arenaTree;
+		arenaTree.assignSorted(items.cbegin(), items.cend());
+		report("RBST with ArenaNodeStorage find", lookup([&arenaTree](int key) { return arenaTree.contains(key); }), lookups);
+	}
+
+	const FrozenTree<int, int> frozenTree(items.cbegin(), items.cend());
+	const FrozenTree<int, int, ThreeWayCompare<int>, VanEmdeBoasLayout> blockedTree(items.cbegin(), items.cend());
+	items = {};
+
+	report("FrozenTree find", lookup([&frozenTree](int key) { return frozenTree.contains(key); }), lookups);
+	report("FrozenTree rank", lookup([&frozenTree](int key) { return frozenTree.rank(key) & 1; }), lookups);
+	report("FrozenTree with VanEmdeBoasLayout find", lookup([&blockedTree](int key) { return blockedTree.contains(key); }), lookups);
+	report("FrozenTree with VanEmdeBoasLayout rank", lookup([&blockedTree](int key) { return blockedTree.rank(key) & 1; }), lookups);
+	report("std::lower_bound on sorted keys", lookup([&sortedKeys](int key) {
+		const auto it = std::lower_bound(sortedKeys.cbegin(), sortedKeys.cend(), key);
+		return it != sortedKeys.cend() && *it == key;
+	}), lookups);
+}
+
+// 4-byte keys: the key arrays take 256 KB, 8 MB and 128 MB.
+void frozenBenchmark(size_t lookups, double scale) {
+	std::cout << "Random lookups in frozen and pointer trees of int keys, " << lookups << " lookups" << std::endl;
+
+	const auto scaled = [scale](size_t n) { return std::max<size_t>(static_cast<size_t>(static_cast<double>(n) * scale), 1); };
+	frozenLookupBenchmark("L2-sized", scaled(size_t{ 1 } << 16), lookups, scaled(size_t{ 1 } << 21));
+	frozenLookupBenchmark("L3-sized", scaled(size_t{ 1 } << 21), lookups, scaled(size_t{ 1 } << 21));
+	frozenLookupBenchmark("DRAM-sized", scaled(size_t{ 1 } << 25), lookups, scaled(size_t{ 1 } << 21));
+}
+
+template <typename Tree>
+void insertRemoveBenchmark(const std::string& name, size_t count) {
+	std::vector<int> keys(count);
+	for (size_t i = 0; i < count; ++i) {
+		keys[i] = static_cast<int>(i);
+	}
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+
+	Tree tree;
+	const auto insertMs = measureMs([&tree, &keys] {
+		tree.clear();
+		for (const auto key : keys) {
+			tree.insert(key, key);
+		}
+	});
+
+	report(name + ", insert", insertMs, keys.size());
+
+	const auto removeMs = measureMs([&tree, &keys] {
+		auto removed = size_t{ 0 };
+		for (const auto key : keys) {
+			removed += tree.remove(key) ? 1 : 0;
+		}
+		sink = sink + removed;
+
+		for (const auto key : keys) {
+			tree.insert(key, key);
+		}
+	});
+
+	report(name + ", remove + reinsert", removeMs, keys.size() * 2);
+}
+
+void randomSourceBenchmark(size_t count) {
+	std::cout << "Insert/remove " << count << " shuffled keys in RBST<int, int>" << std::endl;
+
+	insertRemoveBenchmark<RBST<int, int, SharedNodeStorage, DeviceRandom>>("DeviceRandom", count);
+	insertRemoveBenchmark<RBST<int, int, SharedNodeStorage, XoshiroRandom>>("XoshiroRandom", count);
+	insertRemoveBenchmark<RBST<int, int, ArenaNodeStorage, XoshiroRandom>>("XoshiroRandom, ArenaNodeStorage", count);
+}
+
+
+void bulkLoadBenchmark(size_t count) {
+	std::cout << "Build RBST<int, int> from " << count << " sorted keys" << std::endl;
+
+	std::vector<std::pair<int, int>> items(count);
+	for (size_t i = 0; i < count; ++i) {
+		items[i] = std::make_pair(static_cast<int>(i), static_cast<int>(i));
+	}
+
+	report("insert per key", measureMs([&items] {
+		RBST<int, int> tree;
+		for (const auto& item : items) {
+			tree.insert(item.first, item.second);
+		}
+	}), count);
+
+	report("assignSorted", measureMs([&items] {
+		RBST<int, int> tree;
+		tree.assignSorted(items.cbegin(), items.cend());
+	}), count);
+
+	report("assignSorted, ArenaNodeStorage", measureMs([&items] {
+		RBST<int, int, ArenaNodeStorage> tree;
+		tree.assignSorted(items.cbegin(), items.cend());
+	}), count);
+
+	std::shuffle(items.begin(), items.end(), std::mt19937(3));
+
+	report("range constructor, shuffled input", measureMs([&items] {
+		RBST<int, int> tree(items.cbegin(), items.cend());
+	}), count);
+}
+
+
+void dispatchBenchmark(size_t count, size_t lookups) {
+	std::cout << "Lookup dispatch, " << lookups << " random lookups in " << count << " keys" << std::endl;
+
+	lookupBenchmark<RBST<int, int, ArenaNodeStorage>>("RBST, ArenaNodeStorage", count, lookups);
+
+	AnyBST<int, int> anyTree(RBST<int, int, ArenaNodeStorage>{});
+	lookupBenchmark("AnyBST over RBST, ArenaNodeStorage", anyTree, count, lookups);
+}
+
+
+// Keys share a long prefix so that every comparison walks most of the string.
+std::string prefixedKey(size_t i) {
+	auto digits = std::to_string(i);
+	return "tenant/region/service/object/" + std::string(12 - digits.size(), '0') + digits;
+}
+
+void stringKeyBenchmark(size_t count, size_t lookups) {
+	std::cout << "Look up " << lookups << " random keys in RBST<std::string, int> of " << count << " keys" << std::endl;
+
+	RBST<std::string, int, ArenaNodeStorage> tree;
+	for (size_t i = 0; i < count; ++i) {
+		tree.insert(prefixedKey(i), static_cast<int>(i));
+	}
+
+	std::mt19937 rng(11);
+	std::vector<std::string> keys(lookups);
+	for (auto& key : keys) {
+		key = prefixedKey(rng() % count);
+	}
+
+	report("std::string keys", measureMs([&tree, &keys] {
+		auto found = size_t{ 0 };
+		for (const auto& key : keys) {
+			found += tree.contains(key) ? 1 : 0;
+		}
+		sink = sink + found;
+	}), keys.size());
+
+	std::vector<std::string_view> views(keys.cbegin(), keys.cend());
+
+	report("std::string_view keys, copied into std::string", measureMs([&tree, &views] {
+		auto found = size_t{ 0 };
+		for (const auto& view : views) {
+			found += tree.contains(std::string(view)) ? 1 : 0;
+		}
+		sink = sink + found;
+	}), views.size());
+
+	RBST<std::string, int, ArenaNodeStorage, XoshiroRandom, ThreeWayCompare<>> transparentTree;
+	for (size_t i = 0; i < count; ++i) {
+		transparentTree.insert(prefixedKey(i), static_cast<int>(i));
+	}
+
+	report("std::string_view keys, transparent comparator", measureMs([&transparentTree, &views] {
+		auto found = size_t{ 0 };
+		for (const auto& view : views) {
+			found += transparentTree.contains(view) ? 1 : 0;
+		}
+		sink = sink + found;
+	}), views.size());
+}
+
+std::vector<std::string> payloads(size_t count) {
+	std::vector<std::string> values(count);
+	for (size_t i = 0; i < count; ++i) {
+		values[i] = std::string(64, 'a' + static_cast<char>(i % 26));
+	}
+
+	return values;
+}
+
+void ingestBenchmark(size_t count) {
+	std::cout << "Insert " << count << " keys with 64-byte values into RBST<int, std::string>" << std::endl;
+
+	report("insert(key, std::move(value))", measureMs([count] {
+		auto values = payloads(count);
+		RBST<int, std::string, ArenaNodeStorage> tree;
+		for (size_t i = 0; i < count; ++i) {
+			tree.insert(static_cast<int>(i), std::move(values[i]));
+		}
+	}), count);
+
+	report("insert(key, value), copying", measureMs([count] {
+		const auto values = payloads(count);
+		RBST<int, std::string, ArenaNodeStorage> tree;
+		for (size_t i = 0; i < count; ++i) {
+			tree.insert(static_cast<int>(i), values[i]);
+		}
+	}), count);
+
+	report("tryEmplace(key, 64, char)", measureMs([count] {
+		RBST<int, std::string, ArenaNodeStorage> tree;
+		for (size_t i = 0; i < count; ++i) {
+			tree.tryEmplace(static_cast<int>(i), 64, 'a' + static_cast<char>(i % 26));
+		}
+	}), count);
+}
+
+void counterBenchmark(size_t distinct, size_t updates) {
+	std::cout << "Count " << updates << " random keys out of " << distinct << " in RBST<int, int>" << std::endl;
+
+	std::mt19937 rng(5);
+	std::vector<int> keys(updates);
+	for (auto& key : keys) {
+		key = static_cast<int>(rng() % distinct);
+	}
+
+	RBST<int, int, ArenaNodeStorage> tree;
+
+	report("find, then increment or insert", measureMs([&tree, &keys] {
+		tree.clear();
+		for (const auto key : keys) {
+			auto it = tree.find(key);
+			if (it != tree.end()) {
+				++it->second;
+			} else {
+				tree.insert(key, 1);
+			}
+		}
+	}), keys.size());
+
+	report("upsert", measureMs([&tree, &keys] {
+		tree.clear();
+		for (const auto key : keys) {
+			tree.upsert(key, [](int& count) { ++count; });
+		}
+	}), keys.size());
+
+	report("compute", measureMs([&tree, &keys] {
+		tree.clear();
+		for (const auto key : keys) {
+			tree.compute(key, [](std::optional<int>& count) { count = count.value_or(0) + 1; });
+		}
+	}), keys.size());
+}
+
+void removalBenchmark(size_t count) {
+	std::cout << "Insert, then remove " << count << " keys in RBST<int, int>" << std::endl;
+
+	RBST<int, int, ArenaNodeStorage> tree;
+
+	report("remove", measureMs([&tree, count] {
+		for (size_t key = 0; key < count; ++key) {
+			tree.insert(static_cast<int>(key), 0);
+		}
+
+		auto removed = size_t{ 0 };
+		for (size_t key = 0; key < count; ++key) {
+			removed += tree.remove(static_cast<int>(key)) ? 1 : 0;
+		}
+		sink = sink + removed;
+	}), count * 2);
+
+	report("extract", measureMs([&tree, count] {
+		for (size_t key = 0; key < count; ++key) {
+			tree.insert(static_cast<int>(key), 0);
+		}
+
+		auto extracted = size_t{ 0 };
+		for (size_t key = 0; key < count; ++key) {
+			extracted += tree.extract(static_cast<int>(key)) ? 1 : 0;
+		}
+		sink = sink + extracted;
+	}), count * 2);
+}
+
+template <typename Tree>
+void fillInterleaved(Tree& target, Tree& source, size_t count) {
+	target.clear();
+	source.clear();
+
+	for (size_t i = 0; i < count; ++i) {
+		target.insert(static_cast<int>(2 * i), static_cast<int>(i));
+		source.insert(static_cast<int>(2 * i + 1), static_cast<int>(i));
+	}
+}
+
+template <typename Tree>
+void transferBenchmark(const std::string& name, size_t count) {
+	Tree target;
+	Tree source;
+
+	report(name + ", copy, insert and clear", measureMs([&] { fillInterleaved(target, source, count); }, [&target, &source] {
+		for (const auto& item : source) {
+			target.insert(item.first, item.second);
+		}
+		source.clear();
+	}), count);
+
+	report(name + ", extractNode and insert", measureMs([&] { fillInterleaved(target, source, count); }, [&target, &source, count] {
+		for (size_t i = 0; i < count; ++i) {
+			target.insert(source.extractNode(static_cast<int>(2 * i + 1)));
+		}
+	}), count);
+
+	report(name + ", merge", measureMs([&] { fillInterleaved(target, source, count); }, [&target, &source] {
+		target.merge(source);
+	}), count);
+}
+
+void mergeBenchmark(size_t count) {
+	std::cout << "Move " << count << " interleaved keys between two RBST<int, int> of " << count << " keys" << std::endl;
+
+	transferBenchmark<RBST<int, int>>("SharedNodeStorage", count);
+	transferBenchmark<RBST<int, int, ArenaNodeStorage>>("ArenaNodeStorage", count);
+}
+
+template <typename Tree>
+void batchBenchmark(const std::string& name, size_t count, size_t batchSize) {
+	std::mt19937 random(11);
+	std::uniform_int_distribution<int> keys(0, std::numeric_limits<int>::max());
+
+	std::vector<std::pair<int, int>> items;
+	for (size_t i = 0; i < count; ++i) {
+		items.emplace_back(keys(random), static_cast<int>(i));
+	}
+
+	std::vector<std::pair<int, int>> batch;
+	std::vector<int> batchKeys;
+	for (size_t i = 0; i < batchSize; ++i) {
+		batch.emplace_back(keys(random), static_cast<int>(i));
+		batchKeys.push_back(items[random() % count].first);
+	}
+
+	const Tree base(items.cbegin(), items.cend());
+	Tree tree;
+	const auto copyBase = [&] { tree = base; };
+	const auto batchName = name + ", " + std::to_string(batchSize) + " keys, ";
+
+	report(batchName + "insert per key", measureMs(copyBase, [&] {
+		for (const auto& item : batch) {
+			tree.insert(item.first, item.second);
+		}
+	}), batchSize);
+
+	report(batchName + "multiInsert", measureMs(copyBase, [&] {
+		tree.multiInsert(batch.cbegin(), batch.cend());
+	}), batchSize);
+
+	report(batchName + "remove per key", measureMs(copyBase, [&] {
+		for (const auto key : batchKeys) {
+			tree.remove(key);
+		}
+	}), batchSize);
+
+	report(batchName + "multiRemove", measureMs(copyBase, [&] {
+		tree.multiRemove(batchKeys.cbegin(), batchKeys.cend());
+	}), batchSize);
+
+	sink = sink + tree.size();
+}
+
+void batchBenchmark(size_t count) {
+	std::cout << "Apply batches of random keys to RBST<int, int> of " << count << " random keys" << std::endl;
+
+	for (const auto batchSize : { count / 100, count / 10 }) {
+		batchBenchmark<RBST<int, int>>("SharedNodeStorage", count, batchSize);
+		batchBenchmark<RBST<int, int, ArenaNodeStorage>>("ArenaNodeStorage", count, batchSize);
+	}
+}
+
+template <typename Tree>
+void rangeEraseBenchmark(const std::string& name, size_t count, size_t rangeSize) {
+	std::vector<std::pair<int, int>> items;
+	for (size_t i = 0; i < count; ++i) {
+		items.emplace_back(static_cast<int>(i), static_cast<int>(i));
+	}
+
+	const Tree base(items.cbegin(), items.cend());
+	Tree tree;
+	Tree expired;
+	const auto lo = static_cast<int>(count / 2);
+	const auto hi = static_cast<int>(count / 2 + rangeSize - 1);
+	const auto copyBase = [&] {
+		tree = base;
+		expired.clear();
+	};
+
+	report(name + ", remove per key", measureMs(copyBase, [&] {
+		for (auto key = lo; key <= hi; ++key) {
+			tree.remove(key);
+		}
+	}), rangeSize);
+
+	report(name + ", eraseRange", measureMs(copyBase, [&] {
+		sink = sink + tree.eraseRange(lo, hi);
+	}), rangeSize);
+
+	// The extracted tree is destroyed by the next setup, outside the measurement.
+	report(name + ", extractRange", measureMs(copyBase, [&] {
+		expired = tree.extractRange(lo, hi);
+	}), rangeSize);
+}
+
+void rangeEraseBenchmark(size_t count) {
+	std::cout << "Erase a range of consecutive keys from RBST<int, int> of " << count << " keys" << std::endl;
+
+	for (const auto rangeSize : { count / 1000, count / 10 }) {
+		const auto rangeName = std::to_string(rangeSize) + " keys";
+		rangeEraseBenchmark<RBST<int, int>>("SharedNodeStorage, " + rangeName, count, rangeSize);
+		rangeEraseBenchmark<RBST<int, int, ArenaNodeStorage>>("ArenaNodeStorage, " + rangeName, count, rangeSize);
+	}
+}
+
+template <typename Tree>
+void teardownBenchmark(const std::string& name, const std::vector<std::pair<int, int>>& items) {
+	Tree tree;
+	const auto fill = [&] { tree.assignSorted(items.cbegin(), items.cend()); };
+
+	report(name + ", clear", measureMs(fill, [&] { tree.clear(); }), items.size());
+
+	std::optional<Tree> scoped;
+	report(name + ", destructor", measureMs([&] {
+		scoped.emplace();
+		scoped->assignSorted(items.cbegin(), items.cend());
+	}, [&] {
+		scoped.reset();
+	}), items.size());
+}
+
+void teardownBenchmark(size_t count) {
+	std::cout << "Tear down RBST<int, int> of " << count << " keys" << std::endl;
+
+	std::vector<std::pair<int, int>> items;
+	for (size_t i = 0; i < count; ++i) {
+		items.emplace_back(static_cast<int>(i), static_cast<int>(i));
+	}
+
+	teardownBenchmark<RBST<int, int>>("SharedNodeStorage", items);
+	teardownBenchmark<RBST<int, int, ArenaNodeStorage>>("ArenaNodeStorage", items);
+
+	// Measured last: the reclamation thread makes shared_ptr reference counts atomic for the rest of the process.
+	teardownBenchmark<RBST<int, int, DeferredNodeStorage>>("DeferredNodeStorage", items);
+	NodeReclaimer::instance().drain();
+}
+
+void persistentBenchmark(size_t count, size_t snapshots) {
+	std::cout << "Insert " << count << " random keys, then take snapshots and look them up" << std::endl;
+
+	std::mt19937 random(13);
+	std::vector<int> keys(count);
+	for (auto& key : keys) {
+		key = static_cast<int>(random());
+	}
+
+	RBST<int, int> tree;
+	PersistentRBST<int, int> persistentTree;
+
+	report("RBST insert", measureMs([&] {
+		tree.clear();
+		for (const auto key : keys) {
+			tree.insert(key, key);
+		}
+	}), count);
+
+	report("PersistentRBST insert", measureMs([&] {
+		persistentTree.clear();
+		for (const auto key : keys) {
+			persistentTree.insert(key, key);
+		}
+	}), count);
+
+	const auto copies = std::max<size_t>(snapshots / 100, 1);
+	report("RBST copy", measureMs([&] {
+		for (size_t i = 0; i < copies; ++i) {
+			RBST<int, int> copy(tree);
+			sink = sink + copy.size();
+		}
+	}), copies);
+
+	report("PersistentRBST snapshot", measureMs([&] {
+		for (size_t i = 0; i < snapshots; ++i) {
+			const auto version = persistentTree.snapshot();
+			sink = sink + version.size();
+		}
+	}), snapshots);
+
+	report("RBST find", measureMs([&] {
+		auto found = size_t{ 0 };
+		for (const auto key : keys) {
+			found += tree.contains(key) ? 1 : 0;
+		}
+		sink = sink + found;
+	}), count);
+
+	const auto version = persistentTree.snapshot();
+	report("PersistentRBST::Snapshot find", measureMs([&] {
+		auto found = size_t{ 0 };
+		for (const auto key : keys) {
+			found += version.contains(key) ? 1 : 0;
+		}
+		sink = sink + found;
+	}), count);
+
+	// Measured last: once a second thread exists, shared_ptr reference counts use atomic operations for the rest of the process.
+	std::atomic<bool> writing{ true };
+	std::atomic<size_t> scans{ 0 };
+	std::thread reader([&] {
+		while (writing) {
+			auto scanned = size_t{ 0 };
+			for (const auto& keyValue : persistentTree.snapshot()) {
+				scanned += static_cast<size_t>(keyValue.second & 1);
+			}
+			sink = sink + scanned;
+			++scans;
+		}
+	});
+
+	report("PersistentRBST insert and remove, scanning reader", measureMs([&] {
+		for (const auto key : keys) {
+			persistentTree.remove(key);
+			persistentTree.insert(key, key);
+		}
+	}), count * 2);
+
+	writing = false;
+	reader.join();
+	std::cout << "  reader scanned " << scans << " snapshots" << std::endl;
+}
+
+// Keys of the first tree are multiples of 2, those of the second multiples of step, sorted pairs are kept for the linear baseline.
+void fillMultiples(RBST<int, int>& tree, std::vector<std::pair<int, int>>& items, size_t count, int step) {
+	items.clear();
+	for (size_t i = 0; i < count; ++i) {
+		items.emplace_back(static_cast<int>(i) * step, static_cast<int>(i));
+	}
+
+	tree.assignSorted(items.cbegin(), items.cend());
+}
+
+void setOperationsBenchmark(size_t count, size_t smallCount) {
+	using Tree = RBST<int, int>;
+	using Items = std::vector<std::pair<int, int>>;
+
+	const auto byKey = [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; };
+	const auto parallelCutoff = std::max<size_t>(count / 64, 1);
+
+	Tree first;
+	Tree second;
+	Tree small;
+	Items firstItems;
+	Items secondItems;
+	Items smallItems;
+	fillMultiples(first, firstItems, count, 2);
+	fillMultiples(second, secondItems, count, 3);
+	fillMultiples(small, smallItems, smallCount, 2 * static_cast<int>(count / smallCount));
+
+	std::cout << "Set operations on two RBST<int, int> of " << count << " keys, a third of them shared" << std::endl;
+
+	Tree result;
+	Items merged;
+	const auto copyFirst = [&] { result = first; };
+	const auto copySmall = [&] { result = small; };
+
+	report("unionWith", measureMs(copyFirst, [&] { result.unionWith(second); }), count);
+	report("intersectWith", measureMs(copyFirst, [&] { result.intersectWith(second); }), count);
+	report("differenceWith", measureMs(copyFirst, [&] { result.differenceWith(second); }), count);
+	report("linear std::set_intersection and assignSorted", measureMs([&] {
+		merged.clear();
+		std::set_intersection(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(merged), byKey);
+		result.assignSorted(merged.cbegin(), merged.cend());
+	}), count);
+
+	std::cout << "Set operations between RBST<int, int> of " << count << " and of " << smallCount << " keys" << std::endl;
+
+	report("small intersectWith large", measureMs(copySmall, [&] { result.intersectWith(first); }), smallCount);
+	report("small, linear std::set_intersection and assignSorted", measureMs([&] {
+		merged.clear();
+		std::set_intersection(small.begin(), small.end(), first.begin(), first.end(), std::back_inserter(merged), byKey);
+		result.assignSorted(merged.cbegin(), merged.cend());
+	}), smallCount);
+	report("large differenceWith small", measureMs(copyFirst, [&] { result.differenceWith(small); }), smallCount);
+	report("large, linear std::set_difference and assignSorted", measureMs([&] {
+		merged.clear();
+		std::set_difference(first.begin(), first.end(), small.begin(), small.end(), std::back_inserter(merged), byKey);
+		result.assignSorted(merged.cbegin(), merged.cend());
+	}), smallCount);
+
+	// Measured last: once a second thread exists, shared_ptr reference counts use atomic operations for the rest of the process.
+	std::cout << "Parallel set operations, cutoff " << parallelCutoff << ", " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+	report("unionWith", measureMs(copyFirst, [&] { result.unionWith(second, parallelCutoff); }), count);
+	report("intersectWith", measureMs(copyFirst, [&] { result.intersectWith(second, parallelCutoff); }), count);
+	report("differenceWith", measureMs(copyFirst, [&] { result.differenceWith(second, parallelCutoff); }), count);
+
+	sink = sink + result.size();
+}
+
+// Runs threads workers doing operations each on keys below keyRange: readPercent of them lookups,
+// the rest inserts and removes in equal parts. Returns the wall time until all workers finished.
+template <typename Find, typename Insert, typename Remove>
+double concurrentMs(size_t threads, size_t operations, size_t keyRange, unsigned readPercent, Find&& find, Insert&& insert, Remove&& remove) {
+	return measureMs([&] {
+		std::vector<std::thread> workers;
+		for (size_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t] {
+				XoshiroRandom random(t + 1);
+				auto found = size_t{ 0 };
+
+				for (size_t i = 0; i < operations; ++i) {
+					const auto draw = random();
+					const auto key = static_cast<int>((draw >> 8) % keyRange);
+					const auto kind = static_cast<unsigned>(draw % 100);
+
+					if (kind < readPercent) {
+						found += find(key) ? 1 : 0;
+					} else if (kind % 2 == 0) {
+						insert(key);
+					} else {
+						remove(key);
+					}
+				}
+
+				sink = sink + found;
+			});
+		}
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	});
+}
+
+void concurrentBenchmark(size_t keyRange, size_t operations) {
+	const auto hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const auto maxThreads = std::max<size_t>(hardwareThreads, 4);
+
+	std::cout << "Mixed workloads of " << operations << " operations per thread on " << keyRange / 2 << " of " << keyRange
+	          << " keys, " << hardwareThreads << " hardware threads, ns/op is wall time per operation of all threads" << std::endl;
+
+	ConcurrentRBST<int, int> concurrentTree;
+	RBST<int, int, ArenaNodeStorage> lockedTree;
+	std::shared_mutex treeMutex;
+
+	for (size_t key = 0; key < keyRange; key += 2) {
+		concurrentTree.insert(static_cast<int>(key), static_cast<int>(key));
+		lockedTree.insert(static_cast<int>(key), static_cast<int>(key));
+	}
+
+	for (const auto readPercent : { 100u, 90u, 50u }) {
+		for (const auto threads : threadCounts(maxThreads)) {
+			const auto total = threads * operations;
+			const auto suffix = ", " + std::to_string(readPercent) + "% reads, " + std::to_string(threads) + " threads";
+
+			report("ConcurrentRBST" + suffix, concurrentMs(threads, operations, keyRange, readPercent,
+				[&](int key) { return concurrentTree.contains(key); },
+				[&](int key) { concurrentTree.insert(key, key); },
+				[&](int key) { concurrentTree.remove(key); }), total);
+
+			report("RBST with shared_mutex" + suffix, concurrentMs(threads, operations, keyRange, readPercent,
+				[&](int key) {
+					std::shared_lock<std::shared_mutex> lock(treeMutex);
+					return lockedTree.contains(key);
+				},
+				[&](int key) {
+					std::unique_lock<std::shared_mutex> lock(treeMutex);
+					lockedTree.tryEmplace(key, key);
+				},
+				[&](int key) {
+					std::unique_lock<std::shared_mutex> lock(treeMutex);
+					lockedTree.remove(key);
+				}), total);
+		}
+	}
+}
+
+// Splits keys over threads workers that all call insert(key) on their part, returns the wall time until all finished.
+// The tree is cleared before every repetition.
+template <typename Clear, typename Insert>
+double ingestMs(size_t threads, const std::vector<int>& keys, Clear&& clear, Insert&& insert) {
+	return measureMs(clear, [&] {
+		std::vector<std::thread> workers;
+		for (size_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t] {
+				for (auto i = t; i < keys.size(); i += threads) {
+					insert(keys[i]);
+				}
+			});
+		}
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	});
+}
+
+void shardedBenchmark(size_t count) {
+	const auto hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const auto maxThreads = std::max<size_t>(hardwareThreads, 4);
+
+	std::mt19937 random(17);
+	std::vector<int> keys(count);
+	for (auto& key : keys) {
+		key = static_cast<int>(random());
+	}
+
+	std::cout << "Ingest " << count << " random keys split over the threads, " << hardwareThreads << " hardware threads" << std::endl;
+
+	ShardedRBST<int, int> shardedTree;
+	RBST<int, int> lockedTree;
+	std::mutex treeMutex;
+
+	for (const auto threads : threadCounts(maxThreads)) {
+		const auto suffix = ", " + std::to_string(threads) + " threads";
+
+		report("ShardedRBST, " + std::to_string(shardedTree.shardCount()) + " shards" + suffix, ingestMs(threads, keys, [&] { shardedTree.clear(); }, [&](int key) {
+			shardedTree.insert(key, key);
+		}), count);
+
+		report("RBST with mutex" + suffix, ingestMs(threads, keys, [&] { lockedTree.clear(); }, [&](int key) {
+			std::lock_guard<std::mutex> lock(treeMutex);
+			lockedTree.insert(key, key);
+		}), count);
+	}
+
+	std::cout << "Ordered scan of " << count << " keys" << std::endl;
+
+	report("ShardedRBST merged scan", measureMs([&] {
+		auto sum = size_t{ 0 };
+		for (const auto& keyValue : shardedTree.scan()) {
+			sum += static_cast<size_t>(keyValue.second);
+		}
+		sink = sink + sum;
+	}), count);
+
+	report("RBST scan", measureMs([&] {
+		auto sum = size_t{ 0 };
+		for (const auto& keyValue : lockedTree) {
+			sum += static_cast<size_t>(keyValue.second);
+		}
+		sink = sink + sum;
+	}), count);
+}
+
+// Runs threads readers doing lookups each of random keys below keyRange while update() runs in a loop on another thread.
+// Returns the wall time until all readers finished.
+template <typename Find, typename Update>
+double readScalingMs(size_t threads, size_t lookups, size_t keyRange, Find&& find, Update&& update) {
+	std::atomic<bool> reading{ true };
+	std::thread writer([&] {
+		XoshiroRandom random(0);
+		while (reading) {
+			update(random);
+		}
+	});
+
+	const auto ms = measureMs([&] {
+		std::vector<std::thread> readers;
+		for (size_t t = 0; t < threads; ++t) {
+			readers.emplace_back([&, t] {
+				XoshiroRandom random(t + 1);
+				auto found = size_t{ 0 };
+
+				for (size_t i = 0; i < lookups; ++i) {
+					found += find(static_cast<int>(random() % keyRange)) ? 1 : 0;
+				}
+
+				sink = sink + found;
+			});
+		}
+
+		for (auto& reader : readers) {
+			reader.join();
+		}
+	});
+
+	reading = false;
+	writer.join();
+	return ms;
+}
+
+void rcuBenchmark(size_t keyRange, size_t lookups) {
+	const auto hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const auto maxThreads = std::max<size_t>(hardwareThreads, 4);
+	const auto batchSize = 64;
+
+	std::cout << "Readers doing " << lookups << " lookups each on " << keyRange / 2 << " of " << keyRange << " keys, one writer updating "
+	          << batchSize << " keys per batch and pausing 50 ms, " << hardwareThreads << " hardware threads" << std::endl;
+
+	RcuRBST<int, int> rcuTree;
+	ConcurrentRBST<int, int> concurrentTree;
+	RBST<int, int, ArenaNodeStorage> lockedTree;
+	std::shared_mutex treeMutex;
+
+	for (size_t key = 0; key < keyRange; key += 2) {
+		rcuTree.insert(static_cast<int>(key), static_cast<int>(key));
+		concurrentTree.insert(static_cast<int>(key), static_cast<int>(key));
+		lockedTree.insert(static_cast<int>(key), static_cast<int>(key));
+	}
+	rcuTree.publish();
+
+	// Every batch removes and reinserts keys, so the trees keep their size. The pause gives about 1000 lookups per update.
+	const auto pause = [] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); };
+	const auto drawKey = [keyRange](XoshiroRandom& random) { return static_cast<int>(random() % (keyRange / 2)) * 2; };
+
+	for (const auto threads : threadCounts(maxThreads)) {
+		const auto suffix = ", " + std::to_string(threads) + " readers";
+
+		report("RcuRBST" + suffix, readScalingMs(threads, lookups, keyRange,
+			[&](int key) { return rcuTree.contains(key); },
+			[&](XoshiroRandom& random) {
+				for (auto i = 0; i < batchSize; ++i) {
+					const auto key = drawKey(random);
+					rcuTree.remove(key);
+					rcuTree.insert(key, key);
+				}
+				rcuTree.publish();
+				pause();
+			}), threads * lookups);
+
+		report("ConcurrentRBST" + suffix, readScalingMs(threads, lookups, keyRange,
+			[&](int key) { return concurrentTree.contains(key); },
+			[&](XoshiroRandom& random) {
+				for (auto i = 0; i < batchSize; ++i) {
+					const auto key = drawKey(random);
+					concurrentTree.remove(key);
+					concurrentTree.insert(key, key);
+				}
+				pause();
+			}), threads * lookups);
+
+		report("RBST with shared_mutex" + suffix, readScalingMs(threads, lookups, keyRange,
+			[&](int key) {
+				std::shared_lock<std::shared_mutex> lock(treeMutex);
+				return lockedTree.contains(key);
+			},
+			[&](XoshiroRandom& random) {
+				{
+					std::unique_lock<std::shared_mutex> lock(treeMutex);
+					for (auto i = 0; i < batchSize; ++i) {
+						const auto key = drawKey(random);
+						lockedTree.remove(key);
+						lockedTree.insert(key, key);
+					}
+				}
+				pause();
+			}), threads * lookups);
+	}
+}
+}
+
+// Usage: rbst_benchmark [scale] [section], workload sizes are multiplied by scale,
+// a section name runs only that section.
+int main(int argc, char** argv) {
+	const auto scale = argc > 1 ? std::stod(argv[1]) : 1.0;
+	const auto scaled = [scale](size_t n) { return static_cast<size_t>(static_cast<double>(n) * scale); };
+	const auto section = std::string(argc > 2 ? argv[2] : "");
+	const auto selected = [&section](const std::string& name) { return section.empty() || section == name; };
+
+	if (selected("storage")) {
+		storageBenchmark(scaled(100000));
+	}
+
+	if (selected("layout")) {
+		layoutBenchmark(scaled(100000));
+	}
+
+	if (selected("random")) {
+		randomSourceBenchmark(scaled(100000));
+	}
+
+	if (selected("bulk")) {
+		bulkLoadBenchmark(scaled(1000000));
+	}
+
+	if (selected("dispatch")) {
+		dispatchBenchmark(scaled(1000), scaled(1000000));
+	}
+
+	if (selected("string")) {
+		stringKeyBenchmark(scaled(100000), scaled(1000000));
+	}
+
+	if (selected("ingest")) {
+		ingestBenchmark(scaled(200000));
+	}
+
+	if (selected("counter")) {
+		counterBenchmark(scaled(1000000), scaled(1000000));
+	}
+
+	if (selected("removal")) {
+		removalBenchmark(scaled(100000));
+	}
+
+	if (selected("merge")) {
+		mergeBenchmark(scaled(1000000));
+	}
+
+	if (selected("batch")) {
+		batchBenchmark(scaled(1000000));
+	}
+
+	if (selected("range")) {
+		rangeEraseBenchmark(scaled(1000000));
+	}
+
+	if (selected("latency")) {
+		lookupLatencyBenchmark({ scaled(1000), scaled(1000000), scaled(10000000) }, scaled(1000000));
+	}
+
+	if (selected("frozen")) {
+		frozenBenchmark(scaled(1000000), scale);
+	}
+
+	if (selected("persistent")) {
+		persistentBenchmark(scaled(100000), scaled(1000));
+	}
+
+	if (selected("teardown")) {
+		teardownBenchmark(scaled(10000000));
+	}
+
+	if (selected("setops")) {
+		setOperationsBenchmark(scaled(1000000), scaled(1000));
+	}
+
+	if (selected("concurrent")) {
+		concurrentBenchmark(scaled(1000000), scaled(200000));
+	}
+
+	if (selected("sharded")) {
+		shardedBenchmark(scaled(1000000));
+	}
+
+	if (selected("rcu")) {
+		rcuBenchmark(scaled(1000000), scaled(1000000));
+	}
+
+	return 0;
+}
@@ -0,0 +1,561 @@
+#pragma once
+
+#include "RandomSource.h"
+
+#include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Randomized BST with the RBST interface whose nodes live in one contiguous pool.
+// Links and subtree sizes are 32-bit indices into the pool, which limits the tree to 2^32 - 1 nodes.
+template <typename K, typename V, typename Random = XoshiroRandom>
+class CompactRBST {
+public:
+	class NodeIterator;
+
+	using iterator = NodeIterator;
+	using const_iterator = const NodeIterator;
+	using KVPair = std::pair<K, V>;
+	using Index = uint32_t;
+
+	CompactRBST() = default;
+	explicit CompactRBST(uint64_t seed);
+
+	bool contains(const K& key) const;
+
+	iterator find(const K& key) const;
+
+	void insert(const K& key, const V& value);
+
+	bool remove(const K& key);
+
+	void clear();
+
+	void reserve(size_t capacity);
+
+	void seed(uint64_t seed);
+
+	size_t size() const;
+
+	iterator begin() const;
+	const_iterator cbegin() const;
+
+	iterator end() const;
+	const_iterator cend() const;
+
+	void printTree() const;
+
+	class NodeIterator final {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = KVPair;
+		using difference_type = std::ptrdiff_t;
+		using pointer = KVPair*;
+		using reference = KVPair&;
+
+		NodeIterator() = default;
+		NodeIterator(CompactRBST* tree, Index index);
+
+		NodeIterator& operator++();
+		NodeIterator operator++(int);
+
+		bool operator==(const NodeIterator& other) const;
+		bool operator!=(const NodeIterator& other) const;
+
+		KVPair& operator*();
+		const KVPair& operator*() const;
+
+		KVPair* operator->();
+		const KVPair* operator->() const;
+
+		operator bool() const;
+
+	private:
+		CompactRBST* m_tree{ nullptr };
+		Index m_index{ nil };
+	};
+
+private:
+	static constexpr Index nil = std::numeric_limits<Index>::max();
+
+	struct Node {
+		Node(const KVPair& keyValue);
+
+		// Empty in released slots, so K and V need not be default constructible.
+		std::optional<KVPair> m_keyValue;
+		Index m_size{ 1 };
+		Index m_parent{ nil };
+		Index m_left{ nil };
+		Index m_right{ nil };
+	};
+
+	Index allocateNode(const KVPair& keyValue);
+	void releaseNode(Index node);
+
+	Index next(Index node) const;
+	Index mostLeftNode() const;
+
+	void printBinaryTree(const std::string& prefix, Index node, bool isLeft) const;
+
+	Index safeGetSize(Index node) const;
+	void fixSize(Index node);
+
+	Index find(Index node, const K& key) const;
+
+	Index insert(Index node, Index newNode);
+	Index insertRoot(Index node, Index newNode);
+
+	Index rotateRight(Index node);
+	Index rotateLeft(Index node);
+
+	Index join(Index p, Index q);
+
+	Index remove(Index node, const K& key);
+
+	uint64_t randomBelow(uint64_t bound);
+
+	Random m_random;
+	std::vector<Node> m_nodes;
+	Index m_rootNode{ nil };
+	Index m_freeList{ nil };
+	size_t m_size{ 0 };
+};
+
+template <typename K, typename V, typename Random>
+CompactRBST<K, V, Random>::CompactRBST(uint64_t seed) {
+	this->seed(seed);
+}
+
+template <typename K, typename V, typename Random>
+bool CompactRBST<K, V, Random>::contains(const K& key) const {
+	return find(m_rootNode, key) != nil;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::iterator CompactRBST<K, V, Random>::find(const K& key) const {
+	const auto index = find(m_rootNode, key);
+
+	if (index == nil) {
+		return end();
+	}
+
+	return iterator(const_cast<CompactRBST*>(this), index);
+}
+
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::insert(const K& key, const V& value) {
+	const auto node = allocateNode(std::make_pair(key, value));
+	m_rootNode = insert(m_rootNode, node);
+	m_nodes[m_rootNode].m_parent = nil;
+	++m_size;
+}
+
+template <typename K, typename V, typename Random>
+bool CompactRBST<K, V, Random>::remove(const K& key) {
+	if (!contains(key)) {
+		return false;
+	}
+
+	m_rootNode = remove(m_rootNode, key);
+	if (m_rootNode != nil) {
+		m_nodes[m_rootNode].m_parent = nil;
+	}
+	--m_size;
+
+	return true;
+}
+
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::clear() {
+	m_nodes.clear();
+	m_rootNode = nil;
+	m_freeList = nil;
+	m_size = 0;
+}
+
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::reserve(size_t capacity) {
+	m_nodes.reserve(capacity);
+}
+
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::seed(uint64_t seed) {
+	m_random.seed(seed);
+}
+
+template <typename K, typename V, typename Random>
+size_t CompactRBST<K, V, Random>::size() const {
+	return m_size;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::iterator CompactRBST<K, V, Random>::begin() const {
+	const auto index = mostLeftNode();
+
+	if (index == nil) {
+		return end();
+	}
+
+	return iterator(const_cast<CompactRBST*>(this), index);
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::const_iterator CompactRBST<K, V, Random>::cbegin() const {
+	return begin();
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::iterator CompactRBST<K, V, Random>::end() const {
+	return iterator();
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::const_iterator CompactRBST<K, V, Random>::cend() const {
+	return const_iterator();
+}
+
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::printTree() const {
+	printBinaryTree("", m_rootNode, false);
+}
+
+template <typename K, typename V, typename Random>
+CompactRBST<K, V, Random>::NodeIterator::NodeIterator(CompactRBST* tree, Index index) :
+    m_tree(tree),
+    m_index(index)
+{
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::NodeIterator& CompactRBST<K, V, Random>::NodeIterator::operator++() {
+	m_index = m_tree->next(m_index);
+	if (m_index == nil) {
+		m_tree = nullptr;
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::NodeIterator CompactRBST<K, V, Random>::NodeIterator::operator++(int) {
+	auto tmp = *this;
+	operator++();
+	return tmp;
+}
+
+template <typename K, typename V, typename Random>
+bool CompactRBST<K, V, Random>::NodeIterator::operator==(const NodeIterator& other) const {
+	return m_tree == other.m_tree && m_index == other.m_index;
+}
+
+template <typename K, typename V, typename Random>
+bool CompactRBST<K, V, Random>::NodeIterator::operator!=(const NodeIterator& other) const {
+	return !(*this == other);
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::KVPair& CompactRBST<K, V, Random>::NodeIterator::operator*() {
+	return *m_tree->m_nodes[m_index].m_keyValue;
+}
+
+template <typename K, typename V, typename Random>
+const typename CompactRBST<K, V, Random>::KVPair& CompactRBST<K, V, Random>::NodeIterator::operator*() const {
+	return *m_tree->m_nodes[m_index].m_keyValue;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::KVPair* CompactRBST<K, V, Random>::NodeIterator::operator->() {
+	return &*m_tree->m_nodes[m_index].m_keyValue;
+}
+
+template <typename K, typename V, typename Random>
+const typename CompactRBST<K, V, Random>::KVPair* CompactRBST<K, V, Random>::NodeIterator::operator->() const {
+	return &*m_tree->m_nodes[m_index].m_keyValue;
+}
+
+template <typename K, typename V, typename Random>
+CompactRBST<K, V, Random>::NodeIterator::operator bool() const {
+	return m_index != nil;
+}
+
+template <typename K, typename V, typename Random>
+CompactRBST<K, V, Random>::Node::Node(const KVPair& keyValue) :
+    m_keyValue(keyValue)
+{
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::allocateNode(const KVPair& keyValue) {
+	if (m_freeList != nil) {
+		const auto index = m_freeList;
+		auto& node = m_nodes[index];
+		m_freeList = node.m_left;
+		node.m_keyValue.emplace(keyValue);
+		node.m_size = 1;
+		node.m_left = nil;
+		return index;
+	}
+
+	assert(m_nodes.size() < nil && "CompactRBST node pool is full");
+	m_nodes.emplace_back(keyValue);
+
+	return static_cast<Index>(m_nodes.size() - 1);
+}
+
+// Released slots keep their place in the pool and are chained through m_left.
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::releaseNode(Index index) {
+	auto& node = m_nodes[index];
+	node.m_keyValue.reset();
+	node.m_size = 0;
+	node.m_parent = nil;
+	node.m_right = nil;
+	node.m_left = m_freeList;
+	m_freeList = index;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::next(Index index) const {
+	if (m_nodes[index].m_right != nil) {
+		index = m_nodes[index].m_right;
+		while (m_nodes[index].m_left != nil) {
+			index = m_nodes[index].m_left;
+		}
+
+		return index;
+	}
+
+	auto parent = m_nodes[index].m_parent;
+	while (parent != nil && m_nodes[parent].m_right == index) {
+		index = parent;
+		parent = m_nodes[parent].m_parent;
+	}
+
+	return parent;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::mostLeftNode() const {
+	auto index = m_rootNode;
+	while (index != nil && m_nodes[index].m_left != nil) {
+		index = m_nodes[index].m_left;
+	}
+
+	return index;
+}
+
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::printBinaryTree(const std::string& prefix, Index index, bool isLeft) const {
+	if (index != nil) {
+		const auto& node = m_nodes[index];
+
+		std::string parentStr;
+		if (node.m_parent != nil) {
+			parentStr = " (parent : ";
+			parentStr += std::to_string(m_nodes[node.m_parent].m_keyValue->first);
+			parentStr += ")";
+		}
+
+		std::cout	<< prefix.c_str()
+		            << (isLeft ? "├──" : "└──" )
+		            << " (" << node.m_keyValue->first
+		            << ", " << node.m_keyValue->second << ") "
+		            <<  parentStr << std::endl;
+
+		printBinaryTree(prefix + (isLeft ? "│   " : "    "), node.m_left, true);
+		printBinaryTree(prefix + (isLeft ? "│   " : "    "), node.m_right, false);
+	}
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::safeGetSize(Index index) const {
+	if (index != nil) {
+		return m_nodes[index].m_size;
+	}
+
+	return 0;
+}
+
+template <typename K, typename V, typename Random>
+void CompactRBST<K, V, Random>::fixSize(Index index) {
+	if (index != nil) {
+		auto& node = m_nodes[index];
+		node.m_size = safeGetSize(node.m_left) + safeGetSize(node.m_right) + 1;
+	}
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::find(Index index, const K& key) const {
+	while (index != nil) {
+		const auto& node = m_nodes[index];
+
+		if (node.m_keyValue->first == key) {
+			break;
+		}
+
+		index = node.m_keyValue->first > key ? node.m_left : node.m_right;
+	}
+
+	return index;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::insert(Index index, Index newNode) {
+	if (index == nil) {
+		return newNode;
+	}
+
+	if (randomBelow(m_nodes[index].m_size + 1) == 0) {
+		return insertRoot(index, newNode);
+	}
+
+	if (m_nodes[index].m_keyValue->first > m_nodes[newNode].m_keyValue->first) {
+		const auto left = insert(m_nodes[index].m_left, newNode);
+		m_nodes[index].m_left = left;
+		m_nodes[left].m_parent = index;
+	} else {
+		const auto right = insert(m_nodes[index].m_right, newNode);
+		m_nodes[index].m_right = right;
+		m_nodes[right].m_parent = index;
+	}
+
+	fixSize(index);
+
+	return index;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::insertRoot(Index index, Index newNode) {
+	if (index == nil) {
+		return newNode;
+	}
+
+	if (m_nodes[index].m_keyValue->first > m_nodes[newNode].m_keyValue->first) {
+		const auto left = insertRoot(m_nodes[index].m_left, newNode);
+		m_nodes[index].m_left = left;
+		m_nodes[left].m_parent = index;
+		return rotateRight(index);
+	} else {
+		const auto right = insertRoot(m_nodes[index].m_right, newNode);
+		m_nodes[index].m_right = right;
+		m_nodes[right].m_parent = index;
+		return rotateLeft(index);
+	}
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::rotateRight(Index index) {
+	auto& node = m_nodes[index];
+	const auto q = node.m_left;
+
+	if (q == nil) {
+		return index;
+	}
+
+	m_nodes[q].m_parent = node.m_parent;
+	node.m_left = m_nodes[q].m_right;
+	if (node.m_left != nil) {
+		m_nodes[node.m_left].m_parent = index;
+	}
+	m_nodes[q].m_right = index;
+	node.m_parent = q;
+	m_nodes[q].m_size = node.m_size;
+
+	fixSize(index);
+
+	return q;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::rotateLeft(Index index) {
+	auto& node = m_nodes[index];
+	const auto p = node.m_right;
+
+	if (p == nil) {
+		return index;
+	}
+
+	m_nodes[p].m_parent = node.m_parent;
+	node.m_right = m_nodes[p].m_left;
+	if (node.m_right != nil) {
+		m_nodes[node.m_right].m_parent = index;
+	}
+	m_nodes[p].m_left = index;
+	node.m_parent = p;
+	m_nodes[p].m_size = node.m_size;
+
+	fixSize(index);
+
+	return p;
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::join(Index p, Index q) {
+	if (p == nil) {
+		return q;
+	}
+
+	if (q == nil) {
+		return p;
+	}
+
+	if (randomBelow(m_nodes[p].m_size + m_nodes[q].m_size) < m_nodes[p].m_size) {
+		const auto right = join(m_nodes[p].m_right, q);
+		m_nodes[p].m_right = right;
+		m_nodes[right].m_parent = p;
+		fixSize(p);
+		return p;
+	} else {
+		const auto left = join(p, m_nodes[q].m_left);
+		m_nodes[q].m_left = left;
+		m_nodes[left].m_parent = q;
+		fixSize(q);
+		return q;
+	}
+}
+
+template <typename K, typename V, typename Random>
+typename CompactRBST<K, V, Random>::Index CompactRBST<K, V, Random>::remove(Index index, const K& key) {
+	if (index == nil) {
+		return index;
+	}
+
+	if (m_nodes[index].m_keyValue->first == key) {
+		const auto q = join(m_nodes[index].m_left, m_nodes[index].m_right);
+		if (q != nil) {
+			m_nodes[q].m_parent = m_nodes[index].m_parent;
+		}
+		releaseNode(index);
+		return q;
+	}
+
+	if (m_nodes[index].m_keyValue->first > key) {
+		const auto left = remove(m_nodes[index].m_left, key);
+		m_nodes[index].m_left = left;
+		if (left != nil) {
+			m_nodes[left].m_parent = index;
+		}
+	} else {
+		const auto right = remove(m_nodes[index].m_right, key);
+		m_nodes[index].m_right = right;
+		if (right != nil) {
+			m_nodes[right].m_parent = index;
+		}
+	}
+
+	fixSize(index);
+
+	return index;
+}
+
+template <typename K, typename V, typename Random>
+uint64_t CompactRBST<K, V, Random>::randomBelow(uint64_t bound) {
+	return ::randomBelow(m_random, bound);
+}
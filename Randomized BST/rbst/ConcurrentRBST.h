@@ -0,0 +1,507 @@
+#pragma once
+
+#include "RandomSource.h"
+
+#include <EpochReclaimer.h>
+#include <KeyCompare.h>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Randomized BST that any number of threads may search and update at the same time.
+// It keeps the shape of a treap with random priorities, which has the same distribution as the randomized BST
+// but needs no subtree sizes, so an update only touches the nodes on the search path below its insertion point.
+// Every node carries a version lock: searches read versions instead of locking and restart when a node they
+// passed changed, updates lock only the nodes whose links they change. Removed nodes are freed through
+// EpochReclaimer once no search can still reach them.
+// Keys are unique and values are immutable once inserted; find() returns a copy of the value.
+template <typename K, typename V, typename Random = XoshiroRandom, typename Compare = ThreeWayCompare<K>>
+class ConcurrentRBST {
+public:
+	ConcurrentRBST() = default;
+	explicit ConcurrentRBST(const Compare& compare);
+	~ConcurrentRBST();
+
+	ConcurrentRBST(const ConcurrentRBST&) = delete;
+	ConcurrentRBST& operator=(const ConcurrentRBST&) = delete;
+
+	bool contains(const K& key) const;
+
+	std::optional<V> find(const K& key) const;
+
+	// Returns false and leaves the tree unchanged if key is already present.
+	bool insert(const K& key, const V& value);
+
+	bool remove(const K& key);
+
+	// Exact once concurrent updates have finished.
+	size_t size() const;
+
+	// Not thread-safe: no other thread may access the tree.
+	void clear();
+
+	// Visits the elements in key order. Not thread-safe with respect to updates.
+	template <typename Visitor>
+	void forEach(Visitor&& visitor) const;
+
+private:
+	struct Node;
+
+	// Bit 0 marks a node removed from the tree, bit 1 a locked node, the bits above count the updates.
+	class VersionLock {
+	public:
+		// Fails if the node is locked or removed.
+		bool readLock(uint64_t& version) const;
+		bool validate(uint64_t version) const;
+
+		// Locks the node if it is unchanged since version was read.
+		bool tryLock(uint64_t version);
+		bool tryLock();
+
+		void unlock();
+		void unlockRemoved();
+
+	private:
+		static constexpr uint64_t removedBit = 1;
+		static constexpr uint64_t lockedBit = 2;
+
+		std::atomic<uint64_t> m_version{ 0 };
+	};
+
+	// Links of the head hold the root in m_left.
+	struct Link {
+		std::atomic<Node*> m_left{ nullptr };
+		std::atomic<Node*> m_right{ nullptr };
+		VersionLock m_lock;
+	};
+
+	struct Node : Link {
+		Node(const K& key, const V& value, uint64_t priority);
+
+		const K m_key;
+		const V m_value;
+		const uint64_t m_priority;
+	};
+
+	// A node reached by a search, with the version it had and the parent link leading to it.
+	struct Position {
+		Link* parent;
+		uint64_t parentVersion;
+		std::atomic<Node*>* link;
+		Node* node;
+		uint64_t nodeVersion;
+	};
+
+	// Attempts return false when they raced with an update and must start over.
+	bool tryFind(const K& key, std::optional<V>* value, bool& found) const;
+	bool tryInsert(Node* node, bool& inserted);
+	bool tryRemove(const K& key, bool& removed);
+
+	// Descends from the head until stop(node) holds or the search runs off the tree.
+	template <typename Stop>
+	bool descend(const K& key, Stop&& stop, Position& position) const;
+
+	// Locks node and stores it in locked, fails if it changed since it was read.
+	static bool lockNode(Node* node, std::vector<Node*>& locked);
+	static void unlockAll(std::vector<Node*>& locked);
+
+	static uint64_t drawPriority();
+
+	static void backoff();
+
+	void destroyNodes(Node* root);
+
+	mutable Link m_head;
+	std::atomic<size_t> m_size{ 0 };
+	Compare m_compare{};
+};
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::VersionLock::readLock(uint64_t& version) const {
+	version = m_version.load(std::memory_order_acquire);
+	return (version & (removedBit | lockedBit)) == 0;
+}
+
+// Reads of the links before the fence cannot move past the version check.
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::VersionLock::validate(uint64_t version) const {
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return m_version.load(std::memory_order_relaxed) == version;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::VersionLock::tryLock(uint64_t version) {
+	return m_version.compare_exchange_strong(version, version + lockedBit, std::memory_order_acquire);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::VersionLock::tryLock() {
+	uint64_t version;
+	return readLock(version) && tryLock(version);
+}
+
+// Adding the locked bit again clears it and carries into the counter.
+template <typename K, typename V, typename Random, typename Compare>
+void ConcurrentRBST<K, V, Random, Compare>::VersionLock::unlock() {
+	m_version.fetch_add(lockedBit, std::memory_order_release);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void ConcurrentRBST<K, V, Random, Compare>::VersionLock::unlockRemoved() {
+	m_version.fetch_add(lockedBit | removedBit, std::memory_order_release);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+ConcurrentRBST<K, V, Random, Compare>::Node::Node(const K& key, const V& value, uint64_t priority) :
+    m_key(key),
+    m_value(value),
+    m_priority(priority)
+{
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+ConcurrentRBST<K, V, Random, Compare>::ConcurrentRBST(const Compare& compare) :
+    m_compare(compare)
+{
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+ConcurrentRBST<K, V, Random, Compare>::~ConcurrentRBST() {
+	destroyNodes(m_head.m_left.load());
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::contains(const K& key) const {
+	auto guard = EpochReclaimer::instance().pin();
+
+	bool found;
+	while (!tryFind(key, nullptr, found)) {
+		backoff();
+	}
+
+	return found;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+std::optional<V> ConcurrentRBST<K, V, Random, Compare>::find(const K& key) const {
+	auto guard = EpochReclaimer::instance().pin();
+
+	std::optional<V> value;
+	bool found;
+	while (!tryFind(key, &value, found)) {
+		value.reset();
+		backoff();
+	}
+
+	return value;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::insert(const K& key, const V& value) {
+	auto node = new Node(key, value, drawPriority());
+
+	bool inserted;
+	{
+		auto guard = EpochReclaimer::instance().pin();
+		while (!tryInsert(node, inserted)) {
+			backoff();
+		}
+	}
+
+	if (inserted) {
+		m_size.fetch_add(1, std::memory_order_relaxed);
+	} else {
+		delete node;
+	}
+
+	return inserted;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::remove(const K& key) {
+	auto guard = EpochReclaimer::instance().pin();
+
+	bool removed;
+	while (!tryRemove(key, removed)) {
+		backoff();
+	}
+
+	if (removed) {
+		m_size.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	return removed;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+size_t ConcurrentRBST<K, V, Random, Compare>::size() const {
+	return m_size.load(std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void ConcurrentRBST<K, V, Random, Compare>::clear() {
+	destroyNodes(m_head.m_left.exchange(nullptr));
+	m_size.store(0);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+template <typename Visitor>
+void ConcurrentRBST<K, V, Random, Compare>::forEach(Visitor&& visitor) const {
+	std::vector<const Node*> path;
+	const Node* node = m_head.m_left.load(std::memory_order_acquire);
+
+	while (node || !path.empty()) {
+		for (; node; node = node->m_left.load(std::memory_order_acquire)) {
+			path.push_back(node);
+		}
+
+		node = path.back();
+		path.pop_back();
+		visitor(node->m_key, node->m_value);
+		node = node->m_right.load(std::memory_order_acquire);
+	}
+}
+
+// Hand-over-hand validation: the parent is checked after the version of the child is read, so the child was
+// linked below it at that moment. Rotations and splits lock every node whose key range they change,
+// which keeps the range of any node a search stands on valid as long as its version is.
+template <typename K, typename V, typename Random, typename Compare>
+template <typename Stop>
+bool ConcurrentRBST<K, V, Random, Compare>::descend(const K& key, Stop&& stop, Position& position) const {
+	position.parent = &m_head;
+	if (!m_head.m_lock.readLock(position.parentVersion)) {
+		return false;
+	}
+
+	position.link = &m_head.m_left;
+	position.node = position.link->load(std::memory_order_acquire);
+
+	while (position.node) {
+		if (!position.node->m_lock.readLock(position.nodeVersion) || !position.parent->m_lock.validate(position.parentVersion)) {
+			return false;
+		}
+
+		if (stop(position.node)) {
+			return true;
+		}
+
+		const auto order = threeWayCompare(m_compare, key, position.node->m_key);
+		auto link = order < 0 ? &position.node->m_left : &position.node->m_right;
+		auto next = link->load(std::memory_order_acquire);
+
+		position.parent = position.node;
+		position.parentVersion = position.nodeVersion;
+		position.link = link;
+		position.node = next;
+	}
+
+	return position.parent->m_lock.validate(position.parentVersion);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::tryFind(const K& key, std::optional<V>* value, bool& found) const {
+	Position position;
+	const auto reached = descend(key, [this, &key](const Node* node) {
+		return threeWayCompare(m_compare, key, node->m_key) == 0;
+	}, position);
+
+	if (!reached) {
+		return false;
+	}
+
+	found = position.node != nullptr;
+	if (found && value) {
+		value->emplace(position.node->m_value);
+	}
+
+	return !found || position.node->m_lock.validate(position.nodeVersion);
+}
+
+// The node goes where the first node with a lower priority is on its search path. That subtree is split by key
+// into the two children of the new node, which changes the links of every node on the rest of the search path,
+// so all of them are locked top-down before anything is modified; a node with an equal key is among them.
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::tryInsert(Node* node, bool& inserted) {
+	const auto& key = node->m_key;
+
+	Position position;
+	const auto reached = descend(key, [this, node, &key](const Node* current) {
+		return current->m_priority < node->m_priority || threeWayCompare(m_compare, key, current->m_key) == 0;
+	}, position);
+
+	if (!reached) {
+		return false;
+	}
+
+	if (position.node && threeWayCompare(m_compare, key, position.node->m_key) == 0) {
+		inserted = false;
+		return position.node->m_lock.validate(position.nodeVersion);
+	}
+
+	if (!position.parent->m_lock.tryLock(position.parentVersion)) {
+		return false;
+	}
+
+	std::vector<Node*> locked;
+	for (auto current = position.node; current; ) {
+		if (!lockNode(current, locked)) {
+			unlockAll(locked);
+			position.parent->m_lock.unlock();
+			return false;
+		}
+
+		const auto order = threeWayCompare(m_compare, key, current->m_key);
+		if (order == 0) {
+			unlockAll(locked);
+			position.parent->m_lock.unlock();
+			inserted = false;
+			return true;
+		}
+
+		current = (order < 0 ? current->m_left : current->m_right).load(std::memory_order_relaxed);
+	}
+
+	auto leftLink = &node->m_left;
+	auto rightLink = &node->m_right;
+	for (auto current : locked) {
+		if (threeWayCompare(m_compare, key, current->m_key) < 0) {
+			rightLink->store(current, std::memory_order_release);
+			rightLink = &current->m_left;
+		} else {
+			leftLink->store(current, std::memory_order_release);
+			leftLink = &current->m_right;
+		}
+	}
+
+	leftLink->store(nullptr, std::memory_order_release);
+	rightLink->store(nullptr, std::memory_order_release);
+	position.link->store(node, std::memory_order_release);
+
+	unlockAll(locked);
+	position.parent->m_lock.unlock();
+	inserted = true;
+	return true;
+}
+
+// The children of the removed node are joined along the right spine of the left one and the left spine
+// of the right one. The spine nodes that change are locked before the first link is rewritten.
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::tryRemove(const K& key, bool& removed) {
+	Position position;
+	const auto reached = descend(key, [this, &key](const Node* node) {
+		return threeWayCompare(m_compare, key, node->m_key) == 0;
+	}, position);
+
+	if (!reached) {
+		return false;
+	}
+
+	if (!position.node) {
+		removed = false;
+		return true;
+	}
+
+	if (!position.parent->m_lock.tryLock(position.parentVersion)) {
+		return false;
+	}
+
+	if (!position.node->m_lock.tryLock(position.nodeVersion)) {
+		position.parent->m_lock.unlock();
+		return false;
+	}
+
+	std::vector<Node*> locked;
+	auto left = position.node->m_left.load(std::memory_order_relaxed);
+	auto right = position.node->m_right.load(std::memory_order_relaxed);
+
+	while (left && right) {
+		auto& upper = left->m_priority > right->m_priority ? left : right;
+		if (!lockNode(upper, locked)) {
+			unlockAll(locked);
+			position.node->m_lock.unlock();
+			position.parent->m_lock.unlock();
+			return false;
+		}
+
+		upper = (&upper == &left ? upper->m_right : upper->m_left).load(std::memory_order_relaxed);
+	}
+
+	auto link = position.link;
+	left = position.node->m_left.load(std::memory_order_relaxed);
+	right = position.node->m_right.load(std::memory_order_relaxed);
+
+	for (auto current : locked) {
+		link->store(current, std::memory_order_release);
+		if (current == left) {
+			link = &current->m_right;
+			left = current->m_right.load(std::memory_order_relaxed);
+		} else {
+			link = &current->m_left;
+			right = current->m_left.load(std::memory_order_relaxed);
+		}
+	}
+
+	link->store(left ? left : right, std::memory_order_release);
+
+	unlockAll(locked);
+	position.node->m_lock.unlockRemoved();
+	position.parent->m_lock.unlock();
+
+	EpochReclaimer::instance().retire(position.node);
+	removed = true;
+	return true;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool ConcurrentRBST<K, V, Random, Compare>::lockNode(Node* node, std::vector<Node*>& locked) {
+	if (!node->m_lock.tryLock()) {
+		return false;
+	}
+
+	locked.push_back(node);
+	return true;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void ConcurrentRBST<K, V, Random, Compare>::unlockAll(std::vector<Node*>& locked) {
+	for (auto node : locked) {
+		node->m_lock.unlock();
+	}
+
+	locked.clear();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+uint64_t ConcurrentRBST<K, V, Random, Compare>::drawPriority() {
+	thread_local Random random;
+	return random();
+}
+
+// A failed attempt means another thread holds or just changed a node on the path, let it finish.
+template <typename K, typename V, typename Random, typename Compare>
+void ConcurrentRBST<K, V, Random, Compare>::backoff() {
+	std::this_thread::yield();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void ConcurrentRBST<K, V, Random, Compare>::destroyNodes(Node* root) {
+	std::vector<Node*> pending;
+	if (root) {
+		pending.push_back(root);
+	}
+
+	while (!pending.empty()) {
+		auto node = pending.back();
+		pending.pop_back();
+
+		for (auto child : { node->m_left.load(), node->m_right.load() }) {
+			if (child) {
+				pending.push_back(child);
+			}
+		}
+
+		delete node;
+	}
+}
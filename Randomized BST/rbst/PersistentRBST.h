@@ -0,0 +1,455 @@
+#pragma once
+
+#include "RandomSource.h"
+
+#include <KeyCompare.h>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Randomized BST whose nodes are never modified once they are linked: updates copy the path from the root
+// to the changed node and share every other subtree with the previous version.
+// snapshot() captures the current version in O(1), it stays unchanged while the tree is updated and
+// its nodes are freed when the last snapshot or tree referring to them is gone.
+// A single thread updates the tree, snapshot() may be called from any thread and snapshots may be read on any thread.
+// Keys and values on the updated path are copied, so they should be cheap to copy.
+template <typename K, typename V, typename Random = XoshiroRandom, typename Compare = ThreeWayCompare<K>>
+class PersistentRBST {
+public:
+	class NodeIterator;
+	class Snapshot;
+
+	using iterator = NodeIterator;
+	using const_iterator = NodeIterator;
+	using KVPair = std::pair<K, V>;
+
+	PersistentRBST() = default;
+	explicit PersistentRBST(uint64_t seed);
+
+	bool contains(const K& key) const;
+
+	iterator find(const K& key) const;
+
+	// First element with a key not less than key.
+	iterator lowerBound(const K& key) const;
+
+	// Inserting always adds an element, equal keys are kept in insertion order.
+	void insert(const K& key, const V& value);
+
+	bool remove(const K& key);
+
+	void clear();
+
+	void seed(uint64_t seed);
+
+	size_t size() const;
+
+	// The current version of the tree, in O(1).
+	Snapshot snapshot() const;
+
+	iterator begin() const;
+	const_iterator cbegin() const;
+
+	iterator end() const;
+	const_iterator cend() const;
+
+private:
+	struct Node;
+
+	using NodePtr = std::shared_ptr<const Node>;
+
+	struct Node {
+		Node(const KVPair& keyValue, NodePtr left, NodePtr right);
+
+		KVPair m_keyValue;
+		size_t m_size;
+		NodePtr m_left;
+		NodePtr m_right;
+	};
+
+	static size_t safeGetSize(const NodePtr& node);
+
+	static iterator find(const Node* node, const K& key, const Compare& compare);
+	static iterator lowerBound(const Node* node, const K& key, const Compare& compare);
+	static iterator first(const Node* node);
+
+	// Copy of node with other children.
+	static NodePtr withChildren(const Node& node, NodePtr left, NodePtr right);
+
+	NodePtr insert(const NodePtr& node, const KVPair& keyValue);
+
+	// Splits node into new paths holding keys <= key and keys > key.
+	std::pair<NodePtr, NodePtr> split(const NodePtr& node, const K& key);
+
+	// Returns node itself if it holds no element with key.
+	NodePtr remove(const NodePtr& node, const K& key);
+
+	NodePtr join(const NodePtr& left, const NodePtr& right);
+
+	void publish(NodePtr root);
+
+	uint64_t randomBelow(uint64_t bound);
+
+	Random m_random;
+	NodePtr m_rootNode{};
+	Compare m_compare{};
+};
+
+// Forward iterator over one version. It refers to the nodes without owning them,
+// so the tree or snapshot it came from must keep that version alive.
+template <typename K, typename V, typename Random, typename Compare>
+class PersistentRBST<K, V, Random, Compare>::NodeIterator final {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = KVPair;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const KVPair*;
+	using reference = const KVPair&;
+
+	NodeIterator() = default;
+
+	NodeIterator& operator++();
+	NodeIterator operator++(int);
+
+	bool operator==(const NodeIterator& other) const;
+	bool operator!=(const NodeIterator& other) const;
+
+	const KVPair& operator*() const;
+	const KVPair* operator->() const;
+
+	operator bool() const;
+
+private:
+	friend class PersistentRBST;
+
+	// The current node on top, below it the ancestors whose left subtree holds it.
+	std::vector<const Node*> m_path;
+};
+
+// Read-only version of the tree.
+template <typename K, typename V, typename Random, typename Compare>
+class PersistentRBST<K, V, Random, Compare>::Snapshot {
+public:
+	Snapshot() = default;
+
+	bool contains(const K& key) const;
+
+	iterator find(const K& key) const;
+	iterator lowerBound(const K& key) const;
+
+	size_t size() const;
+
+	iterator begin() const;
+	iterator end() const;
+
+private:
+	friend class PersistentRBST;
+
+	Snapshot(NodePtr root, const Compare& compare);
+
+	NodePtr m_root{};
+	Compare m_compare{};
+};
+
+template <typename K, typename V, typename Random, typename Compare>
+PersistentRBST<K, V, Random, Compare>::PersistentRBST(uint64_t seed) {
+	this->seed(seed);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool PersistentRBST<K, V, Random, Compare>::contains(const K& key) const {
+	return static_cast<bool>(find(key));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::find(const K& key) const {
+	return find(m_rootNode.get(), key, m_compare);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::lowerBound(const K& key) const {
+	return lowerBound(m_rootNode.get(), key, m_compare);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void PersistentRBST<K, V, Random, Compare>::insert(const K& key, const V& value) {
+	publish(insert(m_rootNode, KVPair(key, value)));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool PersistentRBST<K, V, Random, Compare>::remove(const K& key) {
+	auto root = remove(m_rootNode, key);
+	if (root == m_rootNode) {
+		return false;
+	}
+
+	publish(std::move(root));
+
+	return true;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void PersistentRBST<K, V, Random, Compare>::clear() {
+	publish(NodePtr{});
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void PersistentRBST<K, V, Random, Compare>::seed(uint64_t seed) {
+	m_random.seed(seed);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+size_t PersistentRBST<K, V, Random, Compare>::size() const {
+	return safeGetSize(m_rootNode);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::Snapshot PersistentRBST<K, V, Random, Compare>::snapshot() const {
+	return Snapshot(std::atomic_load(&m_rootNode), m_compare);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::begin() const {
+	return first(m_rootNode.get());
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::const_iterator PersistentRBST<K, V, Random, Compare>::cbegin() const {
+	return begin();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::end() const {
+	return iterator();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::const_iterator PersistentRBST<K, V, Random, Compare>::cend() const {
+	return end();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::NodeIterator& PersistentRBST<K, V, Random, Compare>::NodeIterator::operator++() {
+	const auto node = m_path.back();
+	m_path.pop_back();
+
+	for (auto child = node->m_right.get(); child; child = child->m_left.get()) {
+		m_path.push_back(child);
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::NodeIterator PersistentRBST<K, V, Random, Compare>::NodeIterator::operator++(int) {
+	auto tmp = *this;
+	operator++();
+	return tmp;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool PersistentRBST<K, V, Random, Compare>::NodeIterator::operator==(const NodeIterator& other) const {
+	const auto node = m_path.empty() ? nullptr : m_path.back();
+	const auto otherNode = other.m_path.empty() ? nullptr : other.m_path.back();
+	return node == otherNode;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool PersistentRBST<K, V, Random, Compare>::NodeIterator::operator!=(const NodeIterator& other) const {
+	return !(*this == other);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+const typename PersistentRBST<K, V, Random, Compare>::KVPair& PersistentRBST<K, V, Random, Compare>::NodeIterator::operator*() const {
+	return m_path.back()->m_keyValue;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+const typename PersistentRBST<K, V, Random, Compare>::KVPair* PersistentRBST<K, V, Random, Compare>::NodeIterator::operator->() const {
+	return &m_path.back()->m_keyValue;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+PersistentRBST<K, V, Random, Compare>::NodeIterator::operator bool() const {
+	return !m_path.empty();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+PersistentRBST<K, V, Random, Compare>::Snapshot::Snapshot(NodePtr root, const Compare& compare) :
+    m_root(std::move(root)),
+    m_compare(compare)
+{
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool PersistentRBST<K, V, Random, Compare>::Snapshot::contains(const K& key) const {
+	return static_cast<bool>(find(key));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::Snapshot::find(const K& key) const {
+	return PersistentRBST::find(m_root.get(), key, m_compare);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::Snapshot::lowerBound(const K& key) const {
+	return PersistentRBST::lowerBound(m_root.get(), key, m_compare);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+size_t PersistentRBST<K, V, Random, Compare>::Snapshot::size() const {
+	return safeGetSize(m_root);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::Snapshot::begin() const {
+	return first(m_root.get());
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::Snapshot::end() const {
+	return iterator();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+PersistentRBST<K, V, Random, Compare>::Node::Node(const KVPair& keyValue, NodePtr left, NodePtr right) :
+    m_keyValue(keyValue),
+    m_size(safeGetSize(left) + safeGetSize(right) + 1),
+    m_left(std::move(left)),
+    m_right(std::move(right))
+{
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+size_t PersistentRBST<K, V, Random, Compare>::safeGetSize(const NodePtr& node) {
+	return node ? node->m_size : 0;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::find(const Node* node, const K& key, const Compare& compare) {
+	iterator result;
+
+	while (node) {
+		const auto order = threeWayCompare(compare, key, node->m_keyValue.first);
+		if (order == 0) {
+			result.m_path.push_back(node);
+			return result;
+		}
+
+		if (order < 0) {
+			result.m_path.push_back(node);
+			node = node->m_left.get();
+		} else {
+			node = node->m_right.get();
+		}
+	}
+
+	return iterator();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::lowerBound(const Node* node, const K& key, const Compare& compare) {
+	iterator result;
+
+	while (node) {
+		if (compare(node->m_keyValue.first, key)) {
+			node = node->m_right.get();
+		} else {
+			result.m_path.push_back(node);
+			node = node->m_left.get();
+		}
+	}
+
+	return result;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::iterator PersistentRBST<K, V, Random, Compare>::first(const Node* node) {
+	iterator result;
+
+	for (; node; node = node->m_left.get()) {
+		result.m_path.push_back(node);
+	}
+
+	return result;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::NodePtr PersistentRBST<K, V, Random, Compare>::withChildren(const Node& node, NodePtr left, NodePtr right) {
+	return std::make_shared<const Node>(node.m_keyValue, std::move(left), std::move(right));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::NodePtr PersistentRBST<K, V, Random, Compare>::insert(const NodePtr& node, const KVPair& keyValue) {
+	if (!node || randomBelow(node->m_size + 1) == 0) {
+		auto parts = split(node, keyValue.first);
+		return std::make_shared<const Node>(keyValue, std::move(parts.first), std::move(parts.second));
+	}
+
+	if (m_compare(keyValue.first, node->m_keyValue.first)) {
+		return withChildren(*node, insert(node->m_left, keyValue), node->m_right);
+	}
+
+	return withChildren(*node, node->m_left, insert(node->m_right, keyValue));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+std::pair<typename PersistentRBST<K, V, Random, Compare>::NodePtr, typename PersistentRBST<K, V, Random, Compare>::NodePtr> PersistentRBST<K, V, Random, Compare>::split(const NodePtr& node, const K& key) {
+	if (!node) {
+		return {};
+	}
+
+	if (m_compare(key, node->m_keyValue.first)) {
+		auto parts = split(node->m_left, key);
+		return std::make_pair(std::move(parts.first), withChildren(*node, std::move(parts.second), node->m_right));
+	}
+
+	auto parts = split(node->m_right, key);
+	return std::make_pair(withChildren(*node, node->m_left, std::move(parts.first)), std::move(parts.second));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::NodePtr PersistentRBST<K, V, Random, Compare>::remove(const NodePtr& node, const K& key) {
+	if (!node) {
+		return node;
+	}
+
+	const auto order = threeWayCompare(m_compare, key, node->m_keyValue.first);
+	if (order == 0) {
+		return join(node->m_left, node->m_right);
+	}
+
+	if (order < 0) {
+		auto left = remove(node->m_left, key);
+		return left == node->m_left ? node : withChildren(*node, std::move(left), node->m_right);
+	}
+
+	auto right = remove(node->m_right, key);
+	return right == node->m_right ? node : withChildren(*node, node->m_left, std::move(right));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename PersistentRBST<K, V, Random, Compare>::NodePtr PersistentRBST<K, V, Random, Compare>::join(const NodePtr& left, const NodePtr& right) {
+	if (!left || !right) {
+		return left ? left : right;
+	}
+
+	if (randomBelow(left->m_size + right->m_size) < left->m_size) {
+		return withChildren(*left, left->m_left, join(left->m_right, right));
+	}
+
+	return withChildren(*right, join(left, right->m_left), right->m_right);
+}
+
+// Readers load the root atomically in snapshot(), the writer is the only thread storing it.
+template <typename K, typename V, typename Random, typename Compare>
+void PersistentRBST<K, V, Random, Compare>::publish(NodePtr root) {
+	std::atomic_store(&m_rootNode, std::move(root));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+uint64_t PersistentRBST<K, V, Random, Compare>::randomBelow(uint64_t bound) {
+	return ::randomBelow(m_random, bound);
+}
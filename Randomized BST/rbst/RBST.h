@@ -1,110 +1,605 @@
 #pragma once
 
+#include "RandomSource.h"
+
 #include <AbstractBST.h>
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <vector>
 
-template <typename K, typename V>
-class RBST : public AbstractBST<K, V> {
+template <typename K, typename V, typename Storage = SharedNodeStorage, typename Random = XoshiroRandom, typename Compare = ThreeWayCompare<K>>
+class RBST : public AbstractBST<RBST<K, V, Storage, Random, Compare>, K, V, std::bidirectional_iterator_tag, Storage, Compare> {
 public:
-	using AbstractBaseTree = AbstractBST<K, V>;
+	using AbstractBaseTree = AbstractBST<RBST<K, V, Storage, Random, Compare>, K, V, std::bidirectional_iterator_tag, Storage, Compare>;
 	using AbstractBaseTree::find;
 
 	RBST() = default;
+	explicit RBST(uint64_t seed);
+	explicit RBST(const Compare& compare);
+
+	// Copies own their nodes, the structure of other is reproduced node by node.
+	RBST(const RBST& other);
+	RBST(RBST&& other) noexcept = default;
+
+	RBST& operator=(const RBST& other);
+	RBST& operator=(RBST&& other) noexcept = default;
+
+	// Builds the tree from a range of key-value pairs, linear if the range is already sorted by key.
+	template <typename InputIt, typename = std::enable_if_t<!std::is_integral<InputIt>::value>>
+	RBST(InputIt first, InputIt last);
+
+	// Replaces the contents with a range of key-value pairs, sorting them by key first if needed.
+	template <typename InputIt>
+	void assign(InputIt first, InputIt last);
+
+	// Replaces the contents with a range already sorted by key in a single linear pass.
+	template <typename ForwardIt>
+	void assignSorted(ForwardIt first, ForwardIt last);
+
+	using iterator = typename AbstractBaseTree::iterator;
+
+	class NodeHandle;
+
+	// Inserting always adds an element, equal keys are kept in insertion order.
+	void insert(const K& key, const V& value);
+	void insert(K&& key, V&& value);
+
+	// Constructs the key-value pair in place from args and inserts it.
+	template <typename... Args>
+	iterator emplace(Args&&... args);
+
+	// Constructs the value in place from args only if the key is not present yet.
+	template <typename... Args>
+	std::pair<iterator, bool> tryEmplace(const K& key, Args&&... args);
+	template <typename... Args>
+	std::pair<iterator, bool> tryEmplace(K&& key, Args&&... args);
+
+	// Assigns value to the element with the key, or inserts it if there is none.
+	template <typename M>
+	std::pair<iterator, bool> insertOrAssign(const K& key, M&& value);
+	template <typename M>
+	std::pair<iterator, bool> insertOrAssign(K&& key, M&& value);
+
+	// Applies update to the value stored under key, inserting a value-initialized one first if the key is absent.
+	template <typename F>
+	std::pair<iterator, bool> upsert(const K& key, F&& update);
+
+	// Calls remap with the value under key, or with an empty optional if the key is absent.
+	// A value left in the optional is stored, an empty one removes the element. Returns end() if nothing is stored.
+	template <typename F>
+	iterator compute(const K& key, F&& remap);
+
+	bool remove(const K& key);
+
+	// Removes an element with key and returns its value.
+	std::optional<V> extract(const K& key);
+
+	// Takes an element with key out of the tree together with its node, the handle is empty if there is none.
+	NodeHandle extractNode(const K& key);
+
+	// Links the node of the handle into the tree. When the storage cannot share nodes between trees,
+	// a node from another tree is replaced by a new one the key-value pair is moved into.
+	iterator insert(NodeHandle&& handle);
+
+	// Moves every element of other into the tree by a randomized union that relinks the nodes,
+	// expected O(m log(n / m)) for trees of sizes m <= n. Equal keys from other follow the existing ones.
+	// ArenaNodeStorage trees move the key-value pairs of other into new nodes first.
+	void merge(RBST& other);
+	void merge(RBST&& other);
+
+	// Inserts a batch of key-value pairs at once: the batch is sorted, built into a tree in linear time
+	// and united with this one. Equal keys follow the existing ones and keep their order within the batch.
+	template <typename InputIt>
+	void multiInsert(InputIt first, InputIt last, size_t parallelCutoff = sequential);
+
+	// Removes every element whose key is in the batch of keys, returns the number of removed elements.
+	template <typename InputIt>
+	size_t multiRemove(InputIt first, InputIt last, size_t parallelCutoff = sequential);
 
-	void insert(const K& key, const V& value) override;
-	
-	bool remove(const K& key) override;
+	// Moves the elements with keys greater than key into the returned tree.
+	RBST split(const K& key);
+
+	// Removes the elements with keys in [lo, hi] by two splits and a join, returns the number of removed elements.
+	// The structural work is O(log n), destroying the removed nodes is linear in their number.
+	size_t eraseRange(const K& lo, const K& hi);
+
+	// Moves the elements with keys in [lo, hi] into the returned tree in O(log n), so the caller decides
+	// when and on which thread they are destroyed. ArenaNodeStorage trees move the key-value pairs into new nodes.
+	RBST extractRange(const K& lo, const K& hi);
+
+	// Set operations by key in expected O(m log(n / m + 1)) for trees of sizes m <= n, other is left unchanged.
+	// unionWith adds copies of the elements of other whose keys are not in the tree, intersectWith keeps
+	// the elements whose keys are in other and differenceWith removes them.
+	// Subproblems of at least parallelCutoff elements run their two independent halves as parallel tasks,
+	// ArenaNodeStorage trees always run sequentially.
+	void unionWith(const RBST& other, size_t parallelCutoff = sequential);
+	void intersectWith(const RBST& other, size_t parallelCutoff = sequential);
+	void differenceWith(const RBST& other, size_t parallelCutoff = sequential);
+
+	static constexpr size_t sequential = std::numeric_limits<size_t>::max();
+
+	// Reseeds the random source, equal seeds and operation sequences produce equal trees.
+	void seed(uint64_t seed);
 
 	void printTree() const;
 
 private:
-	struct Node final : public AbstractBaseTree::AbstractNode {
-		Node(const typename AbstractBaseTree::KVPair& keyValue);
+	friend AbstractBaseTree;
 
-		typename AbstractBaseTree::AbstractNode::Ptr next() const override;
+	struct Node final : public AbstractBaseTree::AbstractNode {
+		using AbstractBaseTree::AbstractNode::AbstractNode;
 	};
 
 	using NodePtr = typename Node::Ptr;
 
 	void printBinaryTree(const std::string& prefix, const typename Node::Ptr& node, bool isLeft) const;
 
-	size_t safeGetSize(const NodePtr& node) const;
-	void fixSize(NodePtr& node);
+	void fixSize(const NodePtr& node);
+
+	template <typename Key>
+	NodePtr find(const NodePtr& node, const Key& key) const;
 
-	NodePtr find(const NodePtr& node, const K& key) const override;
+	template <typename... Args>
+	NodePtr emplaceNode(Args&&... args);
 
-	NodePtr insert(NodePtr& node, const typename AbstractBaseTree::KVPair& keyValue) override;
-	NodePtr insertRoot(NodePtr& node, const typename AbstractBaseTree::KVPair& keyValue);
+	NodePtr insert(NodePtr& node, const NodePtr& inserted);
+	NodePtr insertRoot(NodePtr& node, const NodePtr& root);
 
-	NodePtr rotateRight(NodePtr& node);
-	NodePtr rotateLeft(NodePtr& node);
+	// Splits node into keys <= key and keys > key, or into keys < key and keys >= key if equalsRight is set.
+	// The roots of both parts get no parent.
+	void split(const NodePtr& node, const K& key, NodePtr& left, NodePtr& right, bool equalsRight = false);
+	void fixSizesUpwards(NodePtr node);
 
 	NodePtr join(NodePtr& p, NodePtr& q);
+	NodePtr join(NodePtr p, NodePtr q, Random& random);
+
+	// Takes the subtree of keys in [lo, hi] out of the tree.
+	NodePtr detachRange(const K& lo, const K& hi);
+
+	// Splits node into keys < key, keys equal to key and keys > key.
+	void split(const NodePtr& node, const K& key, NodePtr& less, NodePtr& equal, NodePtr& greater);
+
+	NodePtr cloneSubtree(const NodePtr& node);
+
+	// A detached subtree of from as a subtree of this tree, its key-value pairs are moved into new nodes
+	// when the storage cannot share nodes between trees.
+	NodePtr adoptSubtree(NodePtr subtree, RBST& from);
+
+	// Union of two trees, equal keys of first come before those of second.
+	NodePtr unite(NodePtr first, NodePtr second, Random& random, unsigned forks, size_t cutoff);
+
+	// Recursive set operations on a part of this tree and a read-only subtree of other, pivoting on the roots of other.
+	// low and high are keys present in the part's tree that bound the subtree of other, elements equal to them are skipped.
+	NodePtr unionKeys(NodePtr part, const NodePtr& other, const K* low, const K* high, Random& random, unsigned forks, size_t cutoff);
+	NodePtr intersectKeys(NodePtr part, const NodePtr& other, Random& random, unsigned forks, size_t cutoff);
+	NodePtr differenceKeys(NodePtr part, const NodePtr& other, Random& random, unsigned forks, size_t cutoff);
+
+	// Removes the keys of the sorted range [first, last) from part, pivoting on its middle key.
+	NodePtr removeSorted(NodePtr part, const K* first, const K* last, Random& random, unsigned forks, size_t cutoff);
+
+	// Runs left on a new task with its own generator and right on the calling thread if parallel is set,
+	// one after the other with random otherwise.
+	template <typename Left, typename Right>
+	static void forkJoin(bool parallel, Random& random, Left&& left, Right&& right);
+
+	static bool shouldFork(size_t size, unsigned forks, size_t cutoff);
+	static unsigned forkDepth();
+	static Random forkRandom(Random& random);
+
+	// Returns the node with key, or links the node made by create() where insert would put it, in a single descent.
+	// create() may return no node to skip the insertion.
+	template <typename Key, typename Create>
+	std::pair<NodePtr, bool> findOrInsert(const Key& key, Create&& create);
+
+	template <typename Key>
+	NodePtr detach(const Key& key);
+	void unlinkNode(NodePtr node);
+
+	uint64_t randomBelow(uint64_t bound);
+	static uint64_t randomBelow(Random& random, uint64_t bound);
 
-	NodePtr remove(NodePtr& p, const K& key) override;
+	Random m_random;
 };
 
-template <typename K, typename V>
-void RBST<K, V>::insert(const K& key, const V& value) {
-	this->m_rootNode = insert(this->m_rootNode, std::make_pair(key, value));
-	++this->m_size;
+// Owning handle to an element taken out of a tree, it can be inserted into any tree of the same type.
+// With ArenaNodeStorage the node stays in the arena of its source tree, which must outlive the handle and not be moved.
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+class RBST<K, V, Storage, Random, Compare>::NodeHandle {
+public:
+	NodeHandle() = default;
+	NodeHandle(NodeHandle&& other) noexcept;
+	~NodeHandle();
+
+	NodeHandle& operator=(NodeHandle&& other) noexcept;
+
+	bool empty() const;
+	explicit operator bool() const;
+
+	K& key() const;
+	V& value() const;
+
+private:
+	friend class RBST;
+
+	using Pool = typename Node::Pool;
+
+	NodeHandle(NodePtr node, Pool* pool);
+
+	void reset();
+
+	NodePtr m_node{};
+	Pool* m_pool{ nullptr };
+};
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>::RBST(uint64_t seed) {
+	this->seed(seed);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>::RBST(const Compare& compare) :
+    AbstractBaseTree(compare)
+{
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>::RBST(const RBST& other) :
+    AbstractBaseTree(other.keyCompare()),
+    m_random(other.m_random)
+{
+	this->m_rootNode = cloneSubtree(other.m_rootNode);
+	this->m_size = other.m_size;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>& RBST<K, V, Storage, Random, Compare>::operator=(const RBST& other) {
+	if (this != &other) {
+		this->clear();
+		this->m_compare = other.m_compare;
+		m_random = other.m_random;
+		this->m_rootNode = cloneSubtree(other.m_rootNode);
+		this->m_size = other.m_size;
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename InputIt, typename>
+RBST<K, V, Storage, Random, Compare>::RBST(InputIt first, InputIt last) {
+	assign(first, last);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename InputIt>
+void RBST<K, V, Storage, Random, Compare>::assign(InputIt first, InputIt last) {
+	std::vector<typename AbstractBaseTree::KVPair> items(first, last);
+
+	const auto byKey = [this](const auto& lhs, const auto& rhs) {
+		return this->keyLess(lhs.first, rhs.first);
+	};
+
+	if (!std::is_sorted(items.cbegin(), items.cend(), byKey)) {
+		std::stable_sort(items.begin(), items.end(), byKey);
+	}
+
+	assignSorted(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename ForwardIt>
+void RBST<K, V, Storage, Random, Compare>::assignSorted(ForwardIt first, ForwardIt last) {
+	assert(std::is_sorted(first, last, [this](const auto& lhs, const auto& rhs) { return this->keyLess(lhs.first, rhs.first); }));
+
+	this->clear();
+
+	const auto count = static_cast<size_t>(std::distance(first, last));
+	this->m_rootNode = this->template buildFromSorted<Node>(first, count);
+	this->m_size = count;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::insert(const K& key, const V& value) {
+	emplaceNode(key, value);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::insert(K&& key, V&& value) {
+	emplaceNode(std::move(key), std::move(value));
 }
 
-template <typename K, typename V>
-bool RBST<K, V>::remove(const K& key) {
-	if (!this->contains(key)) {
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename... Args>
+typename RBST<K, V, Storage, Random, Compare>::iterator RBST<K, V, Storage, Random, Compare>::emplace(Args&&... args) {
+	return this->makeIterator(emplaceNode(std::forward<Args>(args)...));
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename... Args>
+std::pair<typename RBST<K, V, Storage, Random, Compare>::iterator, bool> RBST<K, V, Storage, Random, Compare>::tryEmplace(const K& key, Args&&... args) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	});
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename... Args>
+std::pair<typename RBST<K, V, Storage, Random, Compare>::iterator, bool> RBST<K, V, Storage, Random, Compare>::tryEmplace(K&& key, Args&&... args) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	});
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename M>
+std::pair<typename RBST<K, V, Storage, Random, Compare>::iterator, bool> RBST<K, V, Storage, Random, Compare>::insertOrAssign(const K& key, M&& value) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, key, std::forward<M>(value));
+	});
+
+	if (!result.second) {
+		result.first->m_keyValue.second = std::forward<M>(value);
+	}
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename M>
+std::pair<typename RBST<K, V, Storage, Random, Compare>::iterator, bool> RBST<K, V, Storage, Random, Compare>::insertOrAssign(K&& key, M&& value) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, std::move(key), std::forward<M>(value));
+	});
+
+	if (!result.second) {
+		result.first->m_keyValue.second = std::forward<M>(value);
+	}
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename F>
+std::pair<typename RBST<K, V, Storage, Random, Compare>::iterator, bool> RBST<K, V, Storage, Random, Compare>::upsert(const K& key, F&& update) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+	});
+
+	update(result.first->m_keyValue.second);
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename F>
+typename RBST<K, V, Storage, Random, Compare>::iterator RBST<K, V, Storage, Random, Compare>::compute(const K& key, F&& remap) {
+	std::optional<V> value;
+
+	const auto result = findOrInsert(key, [&] {
+		remap(value);
+		return value ? this->template createNode<Node>(std::in_place, key, std::move(*value)) : NodePtr{};
+	});
+
+	if (!result.first || result.second) {
+		return this->makeIterator(result.first);
+	}
+
+	auto node = result.first;
+	value = std::move(node->m_keyValue.second);
+	remap(value);
+
+	if (value) {
+		node->m_keyValue.second = std::move(*value);
+		return this->makeIterator(node);
+	}
+
+	unlinkNode(node);
+	this->destroyNode(node);
+
+	return this->end();
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+bool RBST<K, V, Storage, Random, Compare>::remove(const K& key) {
+	auto node = detach(key);
+	if (!node) {
 		return false;
 	}
 
-	this->m_rootNode = remove(this->m_rootNode, key);
-	--this->m_size;
+	this->destroyNode(node);
 
 	return true;
 }
 
-template <typename K, typename V>
-void RBST<K, V>::printTree() const {
-	printBinaryTree("", this->m_rootNode, false);
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+std::optional<V> RBST<K, V, Storage, Random, Compare>::extract(const K& key) {
+	auto node = detach(key);
+	if (!node) {
+		return std::nullopt;
+	}
+
+	std::optional<V> value(std::move(node->m_keyValue.second));
+	this->destroyNode(node);
+
+	return value;
 }
 
-template <typename K, typename V>
-RBST<K, V>::Node::Node(const typename AbstractBaseTree::KVPair& keyValue) :
-    AbstractBaseTree::AbstractNode(keyValue)
-{
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::NodeHandle RBST<K, V, Storage, Random, Compare>::extractNode(const K& key) {
+	auto node = detach(key);
+	if (!node) {
+		return NodeHandle();
+	}
+
+	return NodeHandle(node, Node::Pool::transferable ? nullptr : &this->m_nodePool);
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::AbstractBaseTree::AbstractNode::Ptr RBST<K, V>::Node::next() const {
-	typename AbstractBaseTree::AbstractNode::Ptr ptr;
-	auto strongParent = this->m_parent.lock();
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::iterator RBST<K, V, Storage, Random, Compare>::insert(NodeHandle&& handle) {
+	if (handle.empty()) {
+		return this->end();
+	}
 
-	if (!strongParent) {
-		return ptr;
+	if (!Node::Pool::transferable && handle.m_pool != &this->m_nodePool) {
+		auto node = emplaceNode(std::move(handle.m_node->m_keyValue));
+		handle.reset();
+		return this->makeIterator(node);
 	}
 
-	if ((this == strongParent->m_left.get()) && (strongParent->m_right)) {
-		ptr = strongParent->m_right;
-	} else {
-		return strongParent;
+	auto node = std::exchange(handle.m_node, NodePtr{});
+	handle.m_pool = nullptr;
+
+	this->m_rootNode = insert(this->m_rootNode, node);
+	++this->m_size;
+
+	return this->makeIterator(node);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::merge(RBST& other) {
+	if (this == &other || other.m_size == 0) {
+		return;
 	}
 
-	while (true) {
-		if (ptr->m_left) {
-			ptr = ptr->m_left;
-		} else if (ptr->m_right) {
-			ptr = ptr->m_right;
-		} else {
-			break;
-		}
+	const auto count = other.m_size;
+	auto merged = adoptSubtree(std::exchange(other.m_rootNode, NodePtr{}), other);
+	other.m_size = 0;
+
+	this->m_rootNode = unite(this->m_rootNode, merged, m_random, 0, sequential);
+	this->m_rootNode->m_parent = {};
+	this->m_size += count;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::merge(RBST&& other) {
+	merge(other);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename InputIt>
+void RBST<K, V, Storage, Random, Compare>::multiInsert(InputIt first, InputIt last, size_t parallelCutoff) {
+	std::vector<typename AbstractBaseTree::KVPair> items(first, last);
+	if (items.empty()) {
+		return;
+	}
+
+	const auto byKey = [this](const auto& lhs, const auto& rhs) {
+		return this->keyLess(lhs.first, rhs.first);
+	};
+
+	if (!std::is_sorted(items.cbegin(), items.cend(), byKey)) {
+		std::stable_sort(items.begin(), items.end(), byKey);
+	}
+
+	auto it = std::make_move_iterator(items.begin());
+	auto batch = this->template buildFromSorted<Node>(it, items.size());
+
+	this->m_rootNode = unite(this->m_rootNode, batch, m_random, forkDepth(), parallelCutoff);
+	this->m_rootNode->m_parent = {};
+	this->m_size += items.size();
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename InputIt>
+size_t RBST<K, V, Storage, Random, Compare>::multiRemove(InputIt first, InputIt last, size_t parallelCutoff) {
+	std::vector<K> keys(first, last);
+
+	std::sort(keys.begin(), keys.end(), [this](const K& lhs, const K& rhs) {
+		return this->keyLess(lhs, rhs);
+	});
+	keys.erase(std::unique(keys.begin(), keys.end(), [this](const K& lhs, const K& rhs) {
+		return this->compareKeys(lhs, rhs) == 0;
+	}), keys.end());
+
+	const auto sizeBefore = this->m_size;
+	this->m_rootNode = removeSorted(std::exchange(this->m_rootNode, NodePtr{}), keys.data(), keys.data() + keys.size(), m_random, forkDepth(), parallelCutoff);
+	this->m_size = this->safeGetSize(this->m_rootNode);
+
+	return sizeBefore - this->m_size;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare> RBST<K, V, Storage, Random, Compare>::split(const K& key) {
+	RBST result(this->m_compare);
+	result.seed(m_random());
+
+	NodePtr left{};
+	NodePtr right{};
+	split(std::exchange(this->m_rootNode, NodePtr{}), key, left, right);
+
+	this->m_rootNode = left;
+	this->m_size = this->safeGetSize(left);
+
+	result.m_size = this->safeGetSize(right);
+	result.m_rootNode = result.adoptSubtree(right, *this);
+
+	return result;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+size_t RBST<K, V, Storage, Random, Compare>::eraseRange(const K& lo, const K& hi) {
+	auto range = detachRange(lo, hi);
+	const auto count = this->safeGetSize(range);
+	this->m_nodePool.release(range);
+
+	return count;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare> RBST<K, V, Storage, Random, Compare>::extractRange(const K& lo, const K& hi) {
+	RBST result(this->m_compare);
+	result.seed(m_random());
+
+	auto range = detachRange(lo, hi);
+	result.m_size = this->safeGetSize(range);
+	result.m_rootNode = result.adoptSubtree(range, *this);
+
+	return result;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::unionWith(const RBST& other, size_t parallelCutoff) {
+	if (this == &other) {
+		return;
 	}
 
-	return ptr;
+	this->m_rootNode = unionKeys(std::exchange(this->m_rootNode, NodePtr{}), other.m_rootNode, nullptr, nullptr, m_random, forkDepth(), parallelCutoff);
+	this->m_size = this->safeGetSize(this->m_rootNode);
 }
 
-template <typename K, typename V>
-void RBST<K, V>::printBinaryTree(const std::string& prefix, const NodePtr& node, bool isLeft) const {
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::intersectWith(const RBST& other, size_t parallelCutoff) {
+	if (this == &other) {
+		return;
+	}
+
+	this->m_rootNode = intersectKeys(std::exchange(this->m_rootNode, NodePtr{}), other.m_rootNode, m_random, forkDepth(), parallelCutoff);
+	this->m_size = this->safeGetSize(this->m_rootNode);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::differenceWith(const RBST& other, size_t parallelCutoff) {
+	if (this == &other) {
+		this->clear();
+		return;
+	}
+
+	this->m_rootNode = differenceKeys(std::exchange(this->m_rootNode, NodePtr{}), other.m_rootNode, m_random, forkDepth(), parallelCutoff);
+	this->m_size = this->safeGetSize(this->m_rootNode);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::seed(uint64_t seed) {
+	m_random.seed(seed);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::printTree() const {
+	printBinaryTree("", this->m_rootNode, false);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::printBinaryTree(const std::string& prefix, const NodePtr& node, bool isLeft) const {
 	if (node) {
 		std::string parentStr;
-		const auto& strongParent = node->m_parent.lock();
+		const auto& strongParent = node->parent();
 		if (strongParent) {
 			parentStr = " (parent : ";
 			parentStr += std::to_string(strongParent->m_keyValue.first);
@@ -122,161 +617,564 @@ void RBST<K, V>::printBinaryTree(const std::string& prefix, const NodePtr& node,
 	}
 }
 
-template <typename K, typename V>
-size_t RBST<K, V>::safeGetSize(const typename RBST<K, V>::Node::Ptr& node) const {
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::fixSize(const NodePtr& node) {
 	if (node) {
-		return node->m_size;
+		node->m_size = this->safeGetSize(node->m_left) + this->safeGetSize(node->m_right) + 1;
 	}
+}
 
-	return 0;
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename Key>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::find(const NodePtr& node, const Key& key) const {
+	auto link = &node;
+
+	while (*link) {
+		const auto order = this->compareKeys(key, (*link)->m_keyValue.first);
+		if (order == 0) {
+			break;
+		}
+
+		link = order < 0 ? &(*link)->m_left : &(*link)->m_right;
+	}
+
+	return *link;
 }
 
-template <typename K, typename V>
-void RBST<K, V>::fixSize(typename RBST<K, V>::Node::Ptr& node) {
-	if (node) {
-		node->m_size = safeGetSize(node->m_left) + safeGetSize(node->m_right) + 1;
+// Descends while the random draw keeps the new key below the current node, sizes grow on the way down.
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename... Args>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::emplaceNode(Args&&... args) {
+	auto node = this->template createNode<Node>(std::in_place, std::forward<Args>(args)...);
+
+	this->m_rootNode = insert(this->m_rootNode, node);
+	++this->m_size;
+
+	return node;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::insert(NodePtr& node, const NodePtr& inserted) {
+	const auto& key = inserted->m_keyValue.first;
+	auto link = &node;
+	NodePtr parent{};
+
+	while (*link && randomBelow((*link)->m_size + 1) != 0) {
+		parent = *link;
+		++parent->m_size;
+		link = this->keyLess(key, parent->m_keyValue.first) ? &parent->m_left : &parent->m_right;
 	}
+
+	*link = insertRoot(*link, inserted);
+	inserted->m_parent = parent;
+
+	return node;
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::Node::Ptr RBST<K, V>::find(const NodePtr& node, const K& key) const {
-	if (!node || node->m_keyValue.first == key) {
-		return node;
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::insertRoot(NodePtr& node, const NodePtr& root) {
+	split(node, root->m_keyValue.first, root->m_left, root->m_right);
+
+	if (root->m_left) {
+		root->m_left->m_parent = root;
 	}
 
-	if (node->m_keyValue.first > key) {
-		return find(node->m_left, key);
-	} else {
-		return find(node->m_right, key);
+	if (root->m_right) {
+		root->m_right->m_parent = root;
 	}
+
+	fixSize(root);
+
+	return root;
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::Node::Ptr RBST<K, V>::insert(NodePtr& node, const typename AbstractBaseTree::KVPair& keyValue) {
-	if (!node) {
-		return std::make_shared<RBST<K, V>::Node>(keyValue);
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::split(const NodePtr& node, const K& key, NodePtr& left, NodePtr& right, bool equalsRight) {
+	auto current = node;
+	auto leftHook = &left;
+	auto rightHook = &right;
+	NodePtr leftParent{};
+	NodePtr rightParent{};
+
+	while (current) {
+		const auto goesRight = equalsRight ? !this->keyLess(current->m_keyValue.first, key) : this->keyLess(key, current->m_keyValue.first);
+
+		if (goesRight) {
+			*rightHook = current;
+			current->m_parent = rightParent;
+			rightParent = current;
+			rightHook = &current->m_left;
+			current = current->m_left;
+		} else {
+			*leftHook = current;
+			current->m_parent = leftParent;
+			leftParent = current;
+			leftHook = &current->m_right;
+			current = current->m_right;
+		}
 	}
 
-	std::random_device rndDev;
-	if ((rndDev() % (node->m_size + 1)) == 0) {
-		return insertRoot(node, keyValue);
+	*leftHook = nullptr;
+	*rightHook = nullptr;
+
+	fixSizesUpwards(leftParent);
+	fixSizesUpwards(rightParent);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::fixSizesUpwards(NodePtr node) {
+	while (node) {
+		fixSize(node);
+		node = node->parent();
 	}
+}
 
-	if (node->m_keyValue.first > keyValue.first) {
-		node->m_left = insert(node->m_left, keyValue);
-		node->m_left->m_parent = node;
-	} else {
-		node->m_right = insert(node->m_right, keyValue);
-		node->m_right->m_parent = node;
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::detachRange(const K& lo, const K& hi) {
+	if (this->keyLess(hi, lo)) {
+		return NodePtr{};
 	}
 
-	fixSize(node);
+	NodePtr less{};
+	NodePtr notLess{};
+	NodePtr range{};
+	NodePtr greater{};
+	split(std::exchange(this->m_rootNode, NodePtr{}), lo, less, notLess, true);
+	split(notLess, hi, range, greater);
 
-	return node;
+	this->m_rootNode = join(less, greater);
+	this->m_size -= this->safeGetSize(range);
+
+	return range;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::split(const NodePtr& node, const K& key, NodePtr& less, NodePtr& equal, NodePtr& greater) {
+	NodePtr notLess{};
+	split(node, key, less, notLess, true);
+	split(notLess, key, equal, greater);
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::Node::Ptr RBST<K, V>::insertRoot(NodePtr& node, const typename AbstractBaseTree::KVPair& keyValue) {
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::cloneSubtree(const NodePtr& node) {
 	if (!node) {
-		return std::make_shared<RBST<K, V>::Node>(keyValue);
+		return NodePtr{};
+	}
+
+	auto copy = this->template createNode<Node>(node->m_keyValue);
+	copy->m_size = node->m_size;
+	copy->m_left = cloneSubtree(node->m_left);
+	copy->m_right = cloneSubtree(node->m_right);
+
+	if (copy->m_left) {
+		copy->m_left->m_parent = copy;
+	}
+
+	if (copy->m_right) {
+		copy->m_right->m_parent = copy;
 	}
 
-	if (node->m_keyValue.first > keyValue.first) {
-		node->m_left = insertRoot(node->m_left, keyValue);
-		node->m_left->m_parent = node;
-		return rotateRight(node);
+	return copy;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::adoptSubtree(NodePtr subtree, RBST& from) {
+	if constexpr (Node::Pool::transferable) {
+		return subtree;
 	} else {
-		node->m_right = insertRoot(node->m_right, keyValue);
-		node->m_right->m_parent = node;
-		return rotateLeft(node);
+		const auto count = this->safeGetSize(subtree);
+		std::vector<typename AbstractBaseTree::KVPair> items;
+		items.reserve(count);
+
+		std::vector<NodePtr> path;
+		for (auto node = subtree; node || !path.empty(); ) {
+			while (node) {
+				path.push_back(node);
+				node = node->m_left;
+			}
+
+			node = path.back();
+			path.pop_back();
+			items.push_back(std::move(node->m_keyValue));
+			node = node->m_right;
+		}
+
+		from.m_nodePool.release(subtree);
+
+		auto it = std::make_move_iterator(items.begin());
+		return this->template buildFromSorted<Node>(it, count);
+	}
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::join(NodePtr& p, NodePtr& q) {
+	return join(p, q, m_random);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::join(NodePtr left, NodePtr right, Random& random) {
+	NodePtr result{};
+	NodePtr parent{};
+	auto hook = &result;
+
+	while (left && right) {
+		if (randomBelow(random, left->m_size + right->m_size) < left->m_size) {
+			left->m_size += right->m_size;
+			*hook = left;
+			left->m_parent = parent;
+			parent = left;
+			hook = &left->m_right;
+			left = left->m_right;
+		} else {
+			right->m_size += left->m_size;
+			*hook = right;
+			right->m_parent = parent;
+			parent = right;
+			hook = &right->m_left;
+			right = right->m_left;
+		}
+	}
+
+	*hook = left ? left : right;
+	if (*hook) {
+		(*hook)->m_parent = parent;
 	}
+
+	return result;
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::Node::Ptr RBST<K, V>::rotateRight(NodePtr& node) {
-	auto q = node->m_left;
+// Randomized union: the root of the larger tree is more likely to stay on top, the other tree is split around it.
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::unite(NodePtr first, NodePtr second, Random& random, unsigned forks, size_t cutoff) {
+	if (!first || !second) {
+		return first ? first : second;
+	}
+
+	const auto parallel = shouldFork(first->m_size + second->m_size, forks, cutoff);
+	const auto childForks = parallel ? forks - 1 : forks;
+	NodePtr root{};
+	NodePtr left{};
+	NodePtr right{};
 
-	if (!q) {
-		return node;
+	if (randomBelow(random, first->m_size + second->m_size) < first->m_size) {
+		split(second, first->m_keyValue.first, left, right, true);
+		root = first;
+		forkJoin(parallel, random, [&](Random& leftRandom) {
+			root->m_left = unite(first->m_left, left, leftRandom, childForks, cutoff);
+		}, [&] {
+			root->m_right = unite(first->m_right, right, random, childForks, cutoff);
+		});
+	} else {
+		split(first, second->m_keyValue.first, left, right);
+		root = second;
+		forkJoin(parallel, random, [&](Random& leftRandom) {
+			root->m_left = unite(left, second->m_left, leftRandom, childForks, cutoff);
+		}, [&] {
+			root->m_right = unite(right, second->m_right, random, childForks, cutoff);
+		});
 	}
 
-	q->m_parent = node->m_parent;
-	node->m_left = q->m_right;
-	if (node->m_left) {
-		node->m_left->m_parent = node;
+	if (root->m_left) {
+		root->m_left->m_parent = root;
 	}
-	q->m_right = node;
-	node->m_parent = q;
-	q->m_size = node->m_size;
 
-	fixSize(node);
+	if (root->m_right) {
+		root->m_right->m_parent = root;
+	}
 
-	return q;
+	fixSize(root);
+
+	return root;
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::Node::Ptr RBST<K, V>::rotateLeft(NodePtr& node) {
-	auto p = node->m_right;
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::unionKeys(NodePtr part, const NodePtr& other, const K* low, const K* high, Random& random, unsigned forks, size_t cutoff) {
+	if (!other) {
+		return part;
+	}
 
-	if (!p) {
-		return node;
+	if (!part && !low && !high) {
+		return cloneSubtree(other);
 	}
 
-	p->m_parent = node->m_parent;
-	node->m_right = p->m_left;
-	if (node->m_right) {
-		node->m_right->m_parent = node;
+	const auto parallel = shouldFork(this->safeGetSize(part) + other->m_size, forks, cutoff);
+	const auto childForks = parallel ? forks - 1 : forks;
+	const auto& key = other->m_keyValue.first;
+	NodePtr less{};
+	NodePtr equal{};
+	NodePtr greater{};
+	split(part, key, less, equal, greater);
+
+	const auto present = equal || (low && this->compareKeys(key, *low) == 0) || (high && this->compareKeys(key, *high) == 0);
+	const auto bound = present ? &key : nullptr;
+
+	NodePtr left{};
+	NodePtr right{};
+
+	forkJoin(parallel, random, [&](Random& leftRandom) {
+		left = unionKeys(less, other->m_left, low, bound, leftRandom, childForks, cutoff);
+	}, [&] {
+		right = unionKeys(greater, other->m_right, bound, high, random, childForks, cutoff);
+	});
+
+	auto middle = present ? equal : this->template createNode<Node>(other->m_keyValue);
+
+	return join(join(left, middle, random), right, random);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::intersectKeys(NodePtr part, const NodePtr& other, Random& random, unsigned forks, size_t cutoff) {
+	if (!part || !other) {
+		this->m_nodePool.release(part);
+		return NodePtr{};
 	}
-	p->m_left = node;
-	node->m_parent = p;
-	p->m_size = node->m_size;
 
-	fixSize(node);
+	const auto parallel = shouldFork(this->safeGetSize(part) + other->m_size, forks, cutoff);
+	const auto childForks = parallel ? forks - 1 : forks;
+	NodePtr less{};
+	NodePtr equal{};
+	NodePtr greater{};
+	split(part, other->m_keyValue.first, less, equal, greater);
+
+	NodePtr left{};
+	NodePtr right{};
 
-	return p;
+	forkJoin(parallel, random, [&](Random& leftRandom) {
+		left = intersectKeys(less, other->m_left, leftRandom, childForks, cutoff);
+	}, [&] {
+		right = intersectKeys(greater, other->m_right, random, childForks, cutoff);
+	});
+
+	return join(join(left, equal, random), right, random);
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::Node::Ptr RBST<K, V>::join(NodePtr& p, NodePtr& q) {
-	if (!p) {
-		return q;
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::differenceKeys(NodePtr part, const NodePtr& other, Random& random, unsigned forks, size_t cutoff) {
+	if (!part || !other) {
+		return part;
 	}
 
-	if (!q) {
-		return p;
+	const auto parallel = shouldFork(this->safeGetSize(part) + other->m_size, forks, cutoff);
+	const auto childForks = parallel ? forks - 1 : forks;
+	NodePtr less{};
+	NodePtr equal{};
+	NodePtr greater{};
+	split(part, other->m_keyValue.first, less, equal, greater);
+	this->m_nodePool.release(equal);
+
+	NodePtr left{};
+	NodePtr right{};
+
+	forkJoin(parallel, random, [&](Random& leftRandom) {
+		left = differenceKeys(less, other->m_left, leftRandom, childForks, cutoff);
+	}, [&] {
+		right = differenceKeys(greater, other->m_right, random, childForks, cutoff);
+	});
+
+	return join(left, right, random);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::removeSorted(NodePtr part, const K* first, const K* last, Random& random, unsigned forks, size_t cutoff) {
+	if (!part || first == last) {
+		return part;
 	}
 
-	std::random_device rndDev;
-	if ((rndDev() % (p->m_size + q->m_size)) < p->m_size) {
-		p->m_right = join(p->m_right, q);
-		p->m_right->m_parent = p;
-		fixSize(p);
-		return p;
-	} else {
-		q->m_left = join(p, q->m_left);
-		q->m_left->m_parent = q;
-		fixSize(q);
-		return q;
+	const auto parallel = shouldFork(part->m_size + static_cast<size_t>(last - first), forks, cutoff);
+	const auto childForks = parallel ? forks - 1 : forks;
+	const auto middle = first + (last - first) / 2;
+	NodePtr less{};
+	NodePtr equal{};
+	NodePtr greater{};
+	split(part, *middle, less, equal, greater);
+	this->m_nodePool.release(equal);
+
+	NodePtr left{};
+	NodePtr right{};
+
+	forkJoin(parallel, random, [&](Random& leftRandom) {
+		left = removeSorted(less, first, middle, leftRandom, childForks, cutoff);
+	}, [&] {
+		right = removeSorted(greater, middle + 1, last, random, childForks, cutoff);
+	});
+
+	return join(left, right, random);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename Left, typename Right>
+void RBST<K, V, Storage, Random, Compare>::forkJoin(bool parallel, Random& random, Left&& left, Right&& right) {
+	if (!parallel) {
+		left(random);
+		right();
+		return;
 	}
+
+	auto forked = forkRandom(random);
+	auto task = std::async(std::launch::async, [&] { left(forked); });
+	right();
+	task.get();
 }
 
-template <typename K, typename V>
-typename RBST<K, V>::Node::Ptr RBST<K, V>::remove(NodePtr& node, const K& key) {
-	if (!node) {
-		return node;
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+bool RBST<K, V, Storage, Random, Compare>::shouldFork(size_t size, unsigned forks, size_t cutoff) {
+	return Node::Pool::transferable && forks > 0 && cutoff != sequential && size >= cutoff;
+}
+
+// Enough nested forks to occupy every hardware thread about twice.
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+unsigned RBST<K, V, Storage, Random, Compare>::forkDepth() {
+	const auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+	return static_cast<unsigned>(std::log2(threads)) + 1;
+}
+
+// Every task draws from its own generator, seeded from the generator of the task that forks it.
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+Random RBST<K, V, Storage, Random, Compare>::forkRandom(Random& random) {
+	Random forked;
+	forked.seed((static_cast<uint64_t>(random()) << 32) ^ random());
+	return forked;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename Key, typename Create>
+std::pair<typename RBST<K, V, Storage, Random, Compare>::Node::Ptr, bool> RBST<K, V, Storage, Random, Compare>::findOrInsert(const Key& key, Create&& create) {
+	auto link = &this->m_rootNode;
+	NodePtr* parentLink = nullptr;
+
+	while (*link) {
+		const auto order = this->compareKeys(key, (*link)->m_keyValue.first);
+		if (order == 0) {
+			return std::make_pair(*link, false);
+		}
+
+		parentLink = link;
+		link = order < 0 ? &(*link)->m_left : &(*link)->m_right;
+	}
+
+	auto inserted = create();
+	if (!inserted) {
+		return std::make_pair(NodePtr{}, false);
 	}
 
-	if (node->m_keyValue.first == key) {
-		auto q = join(node->m_left, node->m_right);
-		node.reset();
-		return q;
+	// Makes the draws of insert bottom-up, so lookups of present keys pay for none of them: the new node becomes
+	// the root of the topmost subtree whose draw hits. Sizes below that subtree root are recomputed by the split.
+	auto rootLink = link;
+	auto rootParent = parentLink ? *parentLink : NodePtr{};
+
+	for (auto node = rootParent; node; ) {
+		auto parent = node->parent();
+
+		if (randomBelow(node->m_size + 1) == 0) {
+			rootLink = !parent ? &this->m_rootNode : (parent->m_left == node ? &parent->m_left : &parent->m_right);
+			rootParent = parent;
+		}
+
+		++node->m_size;
+		node = parent;
 	}
 
-	if (node->m_keyValue.first > key && (node->m_left = remove(node->m_left, key))) {
-		node->m_left->m_parent = node;
-	} else if ((node->m_right = remove(node->m_right, key))) {
-		node->m_right->m_parent = node;
+	*rootLink = insertRoot(*rootLink, inserted);
+	inserted->m_parent = rootParent;
+	++this->m_size;
+
+	return std::make_pair(inserted, true);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare> template <typename Key>
+typename RBST<K, V, Storage, Random, Compare>::Node::Ptr RBST<K, V, Storage, Random, Compare>::detach(const Key& key) {
+	auto node = find(this->m_rootNode, key);
+	if (node) {
+		unlinkNode(node);
 	}
 
 	return node;
 }
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::unlinkNode(NodePtr node) {
+	auto parent = node->parent();
+	auto& link = !parent ? this->m_rootNode : (parent->m_left == node ? parent->m_left : parent->m_right);
+	auto joined = join(node->m_left, node->m_right);
+
+	if (joined) {
+		joined->m_parent = node->m_parent;
+	}
+
+	link = joined;
+	node->m_left = nullptr;
+	node->m_right = nullptr;
+	node->m_parent = {};
+	--this->m_size;
+
+	while (parent) {
+		--parent->m_size;
+		parent = parent->parent();
+	}
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+uint64_t RBST<K, V, Storage, Random, Compare>::randomBelow(uint64_t bound) {
+	return randomBelow(m_random, bound);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+uint64_t RBST<K, V, Storage, Random, Compare>::randomBelow(Random& random, uint64_t bound) {
+	return ::randomBelow(random, bound);
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>::NodeHandle::NodeHandle(NodePtr node, Pool* pool) :
+    m_node(node),
+    m_pool(pool)
+{
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>::NodeHandle::NodeHandle(NodeHandle&& other) noexcept :
+    m_node(std::exchange(other.m_node, NodePtr{})),
+    m_pool(std::exchange(other.m_pool, nullptr))
+{
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>::NodeHandle::~NodeHandle() {
+	reset();
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+typename RBST<K, V, Storage, Random, Compare>::NodeHandle& RBST<K, V, Storage, Random, Compare>::NodeHandle::operator=(NodeHandle&& other) noexcept {
+	if (this != &other) {
+		reset();
+		m_node = std::exchange(other.m_node, NodePtr{});
+		m_pool = std::exchange(other.m_pool, nullptr);
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+bool RBST<K, V, Storage, Random, Compare>::NodeHandle::empty() const {
+	return !m_node;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+RBST<K, V, Storage, Random, Compare>::NodeHandle::operator bool() const {
+	return !empty();
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+K& RBST<K, V, Storage, Random, Compare>::NodeHandle::key() const {
+	return m_node->m_keyValue.first;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+V& RBST<K, V, Storage, Random, Compare>::NodeHandle::value() const {
+	return m_node->m_keyValue.second;
+}
+
+template <typename K, typename V, typename Storage, typename Random, typename Compare>
+void RBST<K, V, Storage, Random, Compare>::NodeHandle::reset() {
+	if (m_pool) {
+		m_pool->destroy(m_node);
+	}
+
+	m_node = NodePtr{};
+	m_pool = nullptr;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// Random sources for the randomized trees.
+// A source is a uniform random bit generator with 64-bit results that can be reseeded.
+
+// SplitMix64 step, used to expand a single seed into generator state.
+inline uint64_t splitMix64(uint64_t& state) {
+	auto z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// Uniform draw below bound: a multiply-shift of 32 random bits instead of a division, the bias is below bound / 2^32.
+template <typename Random>
+uint64_t randomBelow(Random& random, uint64_t bound);
+
+// xoshiro256** generator owned by a single tree, seeded once from std::random_device unless a seed is given.
+class XoshiroRandom {
+public:
+	using result_type = uint64_t;
+
+	XoshiroRandom();
+	explicit XoshiroRandom(uint64_t seed);
+
+	void seed(uint64_t seed);
+
+	result_type operator()();
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+private:
+	static uint64_t rotl(uint64_t x, int k);
+
+	uint64_t m_state[4];
+};
+
+// Operating system entropy for every draw; reproduces the behavior of the trees before random sources existed.
+class DeviceRandom {
+public:
+	using result_type = std::random_device::result_type;
+
+	DeviceRandom() = default;
+	DeviceRandom(const DeviceRandom&);
+	DeviceRandom& operator=(const DeviceRandom&);
+
+	void seed(uint64_t);
+
+	result_type operator()();
+
+	static constexpr result_type min() { return std::random_device::min(); }
+	static constexpr result_type max() { return std::random_device::max(); }
+
+private:
+	std::random_device m_device;
+};
+
+template <typename Random>
+uint64_t randomBelow(Random& random, uint64_t bound) {
+	const auto bits = static_cast<uint64_t>(random());
+
+	if (bound <= std::numeric_limits<uint32_t>::max()) {
+		const auto high = Random::max() > std::numeric_limits<uint32_t>::max() ? bits >> 32 : bits & std::numeric_limits<uint32_t>::max();
+		return (high * bound) >> 32;
+	}
+
+	return bits % bound;
+}
+
+inline XoshiroRandom::XoshiroRandom() {
+	std::random_device device;
+	seed((static_cast<uint64_t>(device()) << 32) | device());
+}
+
+inline XoshiroRandom::XoshiroRandom(uint64_t seed) {
+	this->seed(seed);
+}
+
+inline void XoshiroRandom::seed(uint64_t seed) {
+	for (auto& word : m_state) {
+		word = splitMix64(seed);
+	}
+}
+
+inline XoshiroRandom::result_type XoshiroRandom::operator()() {
+	const auto result = rotl(m_state[1] * 5, 7) * 9;
+	const auto t = m_state[1] << 17;
+
+	m_state[2] ^= m_state[0];
+	m_state[3] ^= m_state[1];
+	m_state[1] ^= m_state[2];
+	m_state[0] ^= m_state[3];
+	m_state[2] ^= t;
+	m_state[3] = rotl(m_state[3], 45);
+
+	return result;
+}
+
+inline uint64_t XoshiroRandom::rotl(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+inline DeviceRandom::DeviceRandom(const DeviceRandom&) {
+}
+
+inline DeviceRandom& DeviceRandom::operator=(const DeviceRandom&) {
+	return *this;
+}
+
+inline void DeviceRandom::seed(uint64_t) {
+}
+
+inline DeviceRandom::result_type DeviceRandom::operator()() {
+	return m_device();
+}
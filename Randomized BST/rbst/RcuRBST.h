@@ -0,0 +1,581 @@
+#pragma once
+
+#include "RandomSource.h"
+
+#include <EpochReclaimer.h>
+#include <KeyCompare.h>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Randomized BST for read-mostly workloads: readers search a published version of the tree without locks or
+// reference counts, a single writer prepares updates in a working version and makes them visible with publish().
+// Published nodes are never modified. The writer copies the path to a changed node the first time a batch touches it
+// and modifies nodes created in the same batch in place, so a batch of updates costs about one path copy per
+// touched subtree. Replaced nodes are retired to EpochReclaimer when the batch is published and freed once no
+// reader can still see them.
+// Reading is thread-safe on any thread; insert, insertOrAssign, remove, clear and publish must be called by one
+// thread at a time.
+template <typename K, typename V, typename Random = XoshiroRandom, typename Compare = ThreeWayCompare<K>>
+class RcuRBST {
+public:
+	class NodeIterator;
+	class ReadView;
+
+	using iterator = NodeIterator;
+	using KVPair = std::pair<K, V>;
+
+	RcuRBST() = default;
+	explicit RcuRBST(uint64_t seed);
+	~RcuRBST();
+
+	RcuRBST(const RcuRBST&) = delete;
+	RcuRBST& operator=(const RcuRBST&) = delete;
+
+	// Lookups in the published version.
+	bool contains(const K& key) const;
+	std::optional<V> find(const K& key) const;
+
+	// Pins the published version for iteration and repeated lookups. Nodes retired while a view is alive
+	// are not freed, so views should be short-lived.
+	ReadView read() const;
+
+	// Updates of the working version, invisible to readers until publish().
+	// Inserting always adds an element, equal keys are kept in insertion order.
+	void insert(const K& key, const V& value);
+
+	// Returns true if the key was inserted, false if the value of an existing element was replaced.
+	bool insertOrAssign(const K& key, const V& value);
+
+	bool remove(const K& key);
+
+	void clear();
+
+	// Makes the working version visible to readers and retires the nodes it replaced.
+	void publish();
+
+	void seed(uint64_t seed);
+
+	// Size of the working version.
+	size_t size() const;
+
+private:
+	struct Node {
+		Node(const KVPair& keyValue, uint64_t batch);
+
+		KVPair m_keyValue;
+		size_t m_size{ 1 };
+		Node* m_left{ nullptr };
+		Node* m_right{ nullptr };
+
+		// Batch that created the node, the writer may modify it until that batch is published.
+		uint64_t m_batch;
+	};
+
+	// Nodes replaced by one published batch, retired as a single object so a long-lived ReadView
+	// holding the epoch back does not make the reclaimer revisit every node on each publish.
+	struct RetiredBatch {
+		~RetiredBatch();
+
+		std::vector<Node*> m_nodes;
+	};
+
+	static size_t safeGetSize(const Node* node);
+	static void fixSize(Node* node);
+
+	static const Node* findNode(const Node* node, const K& key, const Compare& compare);
+
+	// node itself if it was created in this batch, otherwise a copy that replaces it.
+	Node* writable(Node* node);
+
+	// Frees a node created in this batch, retires any other one with the batch.
+	void discard(Node* node);
+
+	Node* insert(Node* node, Node* inserted);
+
+	// Splits node into keys <= key and keys > key.
+	void split(Node* node, const K& key, Node*& left, Node*& right);
+
+	Node* assign(Node* node, const K& key, const V& value);
+	Node* remove(Node* node, const K& key, bool& removed);
+	Node* join(Node* left, Node* right);
+
+	void destroyNodes(Node* root);
+
+	uint64_t randomBelow(uint64_t bound);
+
+	Random m_random;
+	Node* m_working{ nullptr };
+	std::atomic<const Node*> m_published{ nullptr };
+	std::vector<Node*> m_replaced;
+	uint64_t m_batch{ 1 };
+	Compare m_compare{};
+};
+
+// Forward iterator over a read view, valid while the view is alive.
+template <typename K, typename V, typename Random, typename Compare>
+class RcuRBST<K, V, Random, Compare>::NodeIterator final {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = KVPair;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const KVPair*;
+	using reference = const KVPair&;
+
+	NodeIterator() = default;
+
+	NodeIterator& operator++();
+	NodeIterator operator++(int);
+
+	bool operator==(const NodeIterator& other) const;
+	bool operator!=(const NodeIterator& other) const;
+
+	const KVPair& operator*() const;
+	const KVPair* operator->() const;
+
+	operator bool() const;
+
+private:
+	friend class ReadView;
+
+	// The current node on top, below it the ancestors whose left subtree holds it.
+	std::vector<const Node*> m_path;
+};
+
+// The published version at the time of read(), kept alive by an epoch pin of the calling thread.
+// A view must be destroyed on the thread that created it.
+template <typename K, typename V, typename Random, typename Compare>
+class RcuRBST<K, V, Random, Compare>::ReadView {
+public:
+	bool contains(const K& key) const;
+
+	iterator find(const K& key) const;
+
+	// First element with a key not less than key.
+	iterator lowerBound(const K& key) const;
+
+	size_t size() const;
+
+	iterator begin() const;
+	iterator end() const;
+
+private:
+	friend class RcuRBST;
+
+	ReadView(const Node* root, const Compare& compare);
+
+	EpochReclaimer::Guard m_guard;
+	const Node* m_root;
+	Compare m_compare;
+};
+
+template <typename K, typename V, typename Random, typename Compare>
+RcuRBST<K, V, Random, Compare>::RcuRBST(uint64_t seed) {
+	this->seed(seed);
+}
+
+// Readers must be gone: the working version and the replaced nodes are freed at once.
+template <typename K, typename V, typename Random, typename Compare>
+RcuRBST<K, V, Random, Compare>::~RcuRBST() {
+	destroyNodes(m_working);
+	for (auto node : m_replaced) {
+		delete node;
+	}
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool RcuRBST<K, V, Random, Compare>::contains(const K& key) const {
+	auto guard = EpochReclaimer::instance().pin();
+	return findNode(m_published.load(std::memory_order_acquire), key, m_compare) != nullptr;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+std::optional<V> RcuRBST<K, V, Random, Compare>::find(const K& key) const {
+	auto guard = EpochReclaimer::instance().pin();
+
+	const auto node = findNode(m_published.load(std::memory_order_acquire), key, m_compare);
+	return node ? std::optional<V>(node->m_keyValue.second) : std::nullopt;
+}
+
+// The epoch is pinned before the root is loaded, so the version cannot be freed under the view.
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::ReadView RcuRBST<K, V, Random, Compare>::read() const {
+	auto guard = EpochReclaimer::instance().pin();
+	return ReadView(m_published.load(std::memory_order_acquire), m_compare);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::insert(const K& key, const V& value) {
+	m_working = insert(m_working, new Node(KVPair(key, value), m_batch));
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool RcuRBST<K, V, Random, Compare>::insertOrAssign(const K& key, const V& value) {
+	if (!findNode(m_working, key, m_compare)) {
+		insert(key, value);
+		return true;
+	}
+
+	m_working = assign(m_working, key, value);
+	return false;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool RcuRBST<K, V, Random, Compare>::remove(const K& key) {
+	auto removed = false;
+	m_working = remove(m_working, key, removed);
+	return removed;
+}
+
+// Nodes of this batch are freed now, published ones are retired with the batch.
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::clear() {
+	std::vector<Node*> pending;
+	if (m_working) {
+		pending.push_back(m_working);
+	}
+
+	while (!pending.empty()) {
+		auto node = pending.back();
+		pending.pop_back();
+
+		for (auto child : { node->m_left, node->m_right }) {
+			if (child) {
+				pending.push_back(child);
+			}
+		}
+
+		discard(node);
+	}
+
+	m_working = nullptr;
+}
+
+// Retiring after the store guarantees every reader that can still reach a replaced node pinned its epoch before it.
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::publish() {
+	m_published.store(m_working, std::memory_order_release);
+
+	if (!m_replaced.empty()) {
+		EpochReclaimer::instance().retire(new RetiredBatch{ std::move(m_replaced) });
+		m_replaced.clear();
+	}
+
+	++m_batch;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+RcuRBST<K, V, Random, Compare>::RetiredBatch::~RetiredBatch() {
+	for (auto node : m_nodes) {
+		delete node;
+	}
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::seed(uint64_t seed) {
+	m_random.seed(seed);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+size_t RcuRBST<K, V, Random, Compare>::size() const {
+	return safeGetSize(m_working);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::NodeIterator& RcuRBST<K, V, Random, Compare>::NodeIterator::operator++() {
+	const auto node = m_path.back();
+	m_path.pop_back();
+
+	for (const Node* child = node->m_right; child; child = child->m_left) {
+		m_path.push_back(child);
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::NodeIterator RcuRBST<K, V, Random, Compare>::NodeIterator::operator++(int) {
+	auto tmp = *this;
+	operator++();
+	return tmp;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool RcuRBST<K, V, Random, Compare>::NodeIterator::operator==(const NodeIterator& other) const {
+	const auto node = m_path.empty() ? nullptr : m_path.back();
+	const auto otherNode = other.m_path.empty() ? nullptr : other.m_path.back();
+	return node == otherNode;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool RcuRBST<K, V, Random, Compare>::NodeIterator::operator!=(const NodeIterator& other) const {
+	return !(*this == other);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+const typename RcuRBST<K, V, Random, Compare>::KVPair& RcuRBST<K, V, Random, Compare>::NodeIterator::operator*() const {
+	return m_path.back()->m_keyValue;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+const typename RcuRBST<K, V, Random, Compare>::KVPair* RcuRBST<K, V, Random, Compare>::NodeIterator::operator->() const {
+	return &m_path.back()->m_keyValue;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+RcuRBST<K, V, Random, Compare>::NodeIterator::operator bool() const {
+	return !m_path.empty();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+RcuRBST<K, V, Random, Compare>::ReadView::ReadView(const Node* root, const Compare& compare) :
+    m_guard(EpochReclaimer::instance().pin()),
+    m_root(root),
+    m_compare(compare)
+{
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+bool RcuRBST<K, V, Random, Compare>::ReadView::contains(const K& key) const {
+	return findNode(m_root, key, m_compare) != nullptr;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::iterator RcuRBST<K, V, Random, Compare>::ReadView::find(const K& key) const {
+	iterator result;
+
+	for (auto node = m_root; node; ) {
+		const auto order = threeWayCompare(m_compare, key, node->m_keyValue.first);
+		if (order == 0) {
+			result.m_path.push_back(node);
+			return result;
+		}
+
+		if (order < 0) {
+			result.m_path.push_back(node);
+			node = node->m_left;
+		} else {
+			node = node->m_right;
+		}
+	}
+
+	return iterator();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::iterator RcuRBST<K, V, Random, Compare>::ReadView::lowerBound(const K& key) const {
+	iterator result;
+
+	for (auto node = m_root; node; ) {
+		if (m_compare(node->m_keyValue.first, key)) {
+			node = node->m_right;
+		} else {
+			result.m_path.push_back(node);
+			node = node->m_left;
+		}
+	}
+
+	return result;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+size_t RcuRBST<K, V, Random, Compare>::ReadView::size() const {
+	return safeGetSize(m_root);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::iterator RcuRBST<K, V, Random, Compare>::ReadView::begin() const {
+	iterator result;
+
+	for (auto node = m_root; node; node = node->m_left) {
+		result.m_path.push_back(node);
+	}
+
+	return result;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::iterator RcuRBST<K, V, Random, Compare>::ReadView::end() const {
+	return iterator();
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+RcuRBST<K, V, Random, Compare>::Node::Node(const KVPair& keyValue, uint64_t batch) :
+    m_keyValue(keyValue),
+    m_batch(batch)
+{
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+size_t RcuRBST<K, V, Random, Compare>::safeGetSize(const Node* node) {
+	return node ? node->m_size : 0;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::fixSize(Node* node) {
+	node->m_size = safeGetSize(node->m_left) + safeGetSize(node->m_right) + 1;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+const typename RcuRBST<K, V, Random, Compare>::Node* RcuRBST<K, V, Random, Compare>::findNode(const Node* node, const K& key, const Compare& compare) {
+	while (node) {
+		const auto order = threeWayCompare(compare, key, node->m_keyValue.first);
+		if (order == 0) {
+			return node;
+		}
+
+		node = order < 0 ? node->m_left : node->m_right;
+	}
+
+	return nullptr;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::Node* RcuRBST<K, V, Random, Compare>::writable(Node* node) {
+	if (node->m_batch == m_batch) {
+		return node;
+	}
+
+	auto copy = new Node(*node);
+	copy->m_batch = m_batch;
+	m_replaced.push_back(node);
+	return copy;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::discard(Node* node) {
+	if (node->m_batch == m_batch) {
+		delete node;
+	} else {
+		m_replaced.push_back(node);
+	}
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::Node* RcuRBST<K, V, Random, Compare>::insert(Node* node, Node* inserted) {
+	if (!node || randomBelow(node->m_size + 1) == 0) {
+		split(node, inserted->m_keyValue.first, inserted->m_left, inserted->m_right);
+		fixSize(inserted);
+		return inserted;
+	}
+
+	node = writable(node);
+	if (m_compare(inserted->m_keyValue.first, node->m_keyValue.first)) {
+		node->m_left = insert(node->m_left, inserted);
+	} else {
+		node->m_right = insert(node->m_right, inserted);
+	}
+
+	++node->m_size;
+	return node;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::split(Node* node, const K& key, Node*& left, Node*& right) {
+	if (!node) {
+		left = right = nullptr;
+		return;
+	}
+
+	node = writable(node);
+	if (m_compare(key, node->m_keyValue.first)) {
+		split(node->m_left, key, left, node->m_left);
+		right = node;
+	} else {
+		split(node->m_right, key, node->m_right, right);
+		left = node;
+	}
+
+	fixSize(node);
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::Node* RcuRBST<K, V, Random, Compare>::assign(Node* node, const K& key, const V& value) {
+	node = writable(node);
+
+	const auto order = threeWayCompare(m_compare, key, node->m_keyValue.first);
+	if (order == 0) {
+		node->m_keyValue.second = value;
+	} else if (order < 0) {
+		node->m_left = assign(node->m_left, key, value);
+	} else {
+		node->m_right = assign(node->m_right, key, value);
+	}
+
+	return node;
+}
+
+// Leaves the path untouched when key is absent.
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::Node* RcuRBST<K, V, Random, Compare>::remove(Node* node, const K& key, bool& removed) {
+	if (!node) {
+		return nullptr;
+	}
+
+	const auto order = threeWayCompare(m_compare, key, node->m_keyValue.first);
+	if (order == 0) {
+		auto joined = join(node->m_left, node->m_right);
+		discard(node);
+		removed = true;
+		return joined;
+	}
+
+	auto child = remove(order < 0 ? node->m_left : node->m_right, key, removed);
+	if (!removed) {
+		return node;
+	}
+
+	node = writable(node);
+	(order < 0 ? node->m_left : node->m_right) = child;
+	--node->m_size;
+	return node;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+typename RcuRBST<K, V, Random, Compare>::Node* RcuRBST<K, V, Random, Compare>::join(Node* left, Node* right) {
+	if (!left || !right) {
+		return left ? left : right;
+	}
+
+	if (randomBelow(left->m_size + right->m_size) < left->m_size) {
+		left = writable(left);
+		left->m_right = join(left->m_right, right);
+		fixSize(left);
+		return left;
+	}
+
+	right = writable(right);
+	right->m_left = join(left, right->m_left);
+	fixSize(right);
+	return right;
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+void RcuRBST<K, V, Random, Compare>::destroyNodes(Node* root) {
+	std::vector<Node*> pending;
+	if (root) {
+		pending.push_back(root);
+	}
+
+	while (!pending.empty()) {
+		auto node = pending.back();
+		pending.pop_back();
+
+		for (auto child : { node->m_left, node->m_right }) {
+			if (child) {
+				pending.push_back(child);
+			}
+		}
+
+		delete node;
+	}
+}
+
+template <typename K, typename V, typename Random, typename Compare>
+uint64_t RcuRBST<K, V, Random, Compare>::randomBelow(uint64_t bound) {
+	return ::randomBelow(m_random, bound);
+}
@@ -0,0 +1,421 @@
+#pragma once
+
+#include "RBST.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ordered map split over independent RBST shards, each behind its own reader-writer lock.
+// Keys are assigned to shards by hash, so writers of different keys rarely wait for each other and all elements
+// with equal keys live in one shard. Point operations lock one shard, aggregates lock the shards one after another
+// and are exact only while no thread updates the tree. Ordered iteration goes through scan(), which holds every
+// shard for reading and merges them by key; a thread holding a scan must not update the tree.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Storage = SharedNodeStorage, typename Random = XoshiroRandom,
+          typename Compare = ThreeWayCompare<K>>
+class ShardedRBST {
+public:
+	using ShardTree = RBST<K, V, Storage, Random, Compare>;
+	using KVPair = std::pair<K, V>;
+
+	class MergeIterator;
+	class Scan;
+
+	using iterator = MergeIterator;
+
+	// One shard per hardware thread, at least four.
+	ShardedRBST();
+	explicit ShardedRBST(size_t shardCount);
+
+	// Every shard orders its keys by a copy of compare, scans merge the shards by it too.
+	ShardedRBST(size_t shardCount, const Compare& compare);
+
+	ShardedRBST(const ShardedRBST&) = delete;
+	ShardedRBST& operator=(const ShardedRBST&) = delete;
+
+	bool contains(const K& key) const;
+
+	// Copy of the value of the first element with key.
+	std::optional<V> find(const K& key) const;
+
+	// Inserting always adds an element, equal keys are kept in insertion order.
+	void insert(const K& key, const V& value);
+
+	// Returns true if the key was inserted, false if the value of an existing element was replaced.
+	bool insertOrAssign(const K& key, const V& value);
+
+	bool remove(const K& key);
+
+	// Groups a batch of key-value pairs by shard and locks every shard once for its part of the batch.
+	template <typename InputIt>
+	void multiInsert(InputIt first, InputIt last);
+
+	void clear();
+
+	size_t size() const;
+
+	// Number of elements with keys less than key, or with keys in [low, high].
+	size_t rank(const K& key) const;
+	size_t countRange(const K& low, const K& high) const;
+
+	size_t shardCount() const;
+
+	// Locks every shard for reading until the scan is destroyed.
+	Scan scan() const;
+
+private:
+	struct alignas(64) Shard {
+		mutable std::shared_mutex m_mutex;
+		ShardTree m_tree;
+	};
+
+	static size_t defaultShardCount();
+
+	Shard& shardFor(const K& key) const;
+	size_t shardIndex(const K& key) const;
+
+	std::unique_ptr<Shard[]> m_shards;
+	size_t m_shardCount;
+	Hash m_hash{};
+	Compare m_compare{};
+};
+
+// Forward iterator merging the shards by key with a binary heap of shard cursors, O(log shards) per step.
+// The heap holds cursor indices, so the cursors and their ancestor paths never move.
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+class ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator final {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = KVPair;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const KVPair*;
+	using reference = const KVPair&;
+
+	MergeIterator() = default;
+
+	MergeIterator& operator++();
+	MergeIterator operator++(int);
+
+	bool operator==(const MergeIterator& other) const;
+	bool operator!=(const MergeIterator& other) const;
+
+	const KVPair& operator*() const;
+	const KVPair* operator->() const;
+
+	operator bool() const;
+
+private:
+	friend class Scan;
+
+	using Cursor = std::pair<typename ShardTree::iterator, typename ShardTree::iterator>;
+
+	MergeIterator(std::vector<Cursor> cursors, const Compare& compare);
+
+	const Cursor& top() const;
+
+	// Heap order, the cursor with the least key on top.
+	bool later(size_t lhs, size_t rhs) const;
+
+	std::vector<Cursor> m_cursors;
+	std::vector<size_t> m_heap;
+	Compare m_compare{};
+};
+
+// All elements in key order, with every shard locked for reading.
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+class ShardedRBST<K, V, Hash, Storage, Random, Compare>::Scan {
+public:
+	iterator begin() const;
+	iterator end() const;
+
+	// First element with a key not less than key.
+	iterator lowerBound(const K& key) const;
+
+	size_t size() const;
+
+private:
+	friend class ShardedRBST;
+
+	explicit Scan(const ShardedRBST* tree);
+
+	const ShardedRBST* m_tree;
+	std::vector<std::shared_lock<std::shared_mutex>> m_locks;
+};
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+ShardedRBST<K, V, Hash, Storage, Random, Compare>::ShardedRBST() :
+    ShardedRBST(defaultShardCount())
+{
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+ShardedRBST<K, V, Hash, Storage, Random, Compare>::ShardedRBST(size_t shardCount) :
+    ShardedRBST(shardCount, Compare())
+{
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+ShardedRBST<K, V, Hash, Storage, Random, Compare>::ShardedRBST(size_t shardCount, const Compare& compare) :
+    m_shards(new Shard[std::max<size_t>(shardCount, 1)]),
+    m_shardCount(std::max<size_t>(shardCount, 1)),
+    m_compare(compare)
+{
+	for (size_t i = 0; i < m_shardCount; ++i) {
+		m_shards[i].m_tree = ShardTree(compare);
+	}
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+bool ShardedRBST<K, V, Hash, Storage, Random, Compare>::contains(const K& key) const {
+	auto& shard = shardFor(key);
+	std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+	return shard.m_tree.contains(key);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+std::optional<V> ShardedRBST<K, V, Hash, Storage, Random, Compare>::find(const K& key) const {
+	auto& shard = shardFor(key);
+	std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+
+	const auto it = shard.m_tree.find(key);
+	return it != shard.m_tree.end() ? std::optional<V>(it->second) : std::nullopt;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+void ShardedRBST<K, V, Hash, Storage, Random, Compare>::insert(const K& key, const V& value) {
+	auto& shard = shardFor(key);
+	std::lock_guard<std::shared_mutex> lock(shard.m_mutex);
+	shard.m_tree.insert(key, value);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+bool ShardedRBST<K, V, Hash, Storage, Random, Compare>::insertOrAssign(const K& key, const V& value) {
+	auto& shard = shardFor(key);
+	std::lock_guard<std::shared_mutex> lock(shard.m_mutex);
+	return shard.m_tree.insertOrAssign(key, value).second;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+bool ShardedRBST<K, V, Hash, Storage, Random, Compare>::remove(const K& key) {
+	auto& shard = shardFor(key);
+	std::lock_guard<std::shared_mutex> lock(shard.m_mutex);
+	return shard.m_tree.remove(key);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+template <typename InputIt>
+void ShardedRBST<K, V, Hash, Storage, Random, Compare>::multiInsert(InputIt first, InputIt last) {
+	std::vector<std::vector<KVPair>> batches(m_shardCount);
+	for (; first != last; ++first) {
+		const KVPair& keyValue = *first;
+		batches[shardIndex(keyValue.first)].push_back(keyValue);
+	}
+
+	for (size_t i = 0; i < m_shardCount; ++i) {
+		if (!batches[i].empty()) {
+			std::lock_guard<std::shared_mutex> lock(m_shards[i].m_mutex);
+			m_shards[i].m_tree.multiInsert(batches[i].cbegin(), batches[i].cend());
+		}
+	}
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+void ShardedRBST<K, V, Hash, Storage, Random, Compare>::clear() {
+	for (size_t i = 0; i < m_shardCount; ++i) {
+		std::lock_guard<std::shared_mutex> lock(m_shards[i].m_mutex);
+		m_shards[i].m_tree.clear();
+	}
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+size_t ShardedRBST<K, V, Hash, Storage, Random, Compare>::size() const {
+	auto total = size_t{ 0 };
+	for (size_t i = 0; i < m_shardCount; ++i) {
+		std::shared_lock<std::shared_mutex> lock(m_shards[i].m_mutex);
+		total += m_shards[i].m_tree.size();
+	}
+
+	return total;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+size_t ShardedRBST<K, V, Hash, Storage, Random, Compare>::rank(const K& key) const {
+	auto total = size_t{ 0 };
+	for (size_t i = 0; i < m_shardCount; ++i) {
+		std::shared_lock<std::shared_mutex> lock(m_shards[i].m_mutex);
+		total += m_shards[i].m_tree.rank(key);
+	}
+
+	return total;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+size_t ShardedRBST<K, V, Hash, Storage, Random, Compare>::countRange(const K& low, const K& high) const {
+	auto total = size_t{ 0 };
+	for (size_t i = 0; i < m_shardCount; ++i) {
+		std::shared_lock<std::shared_mutex> lock(m_shards[i].m_mutex);
+		total += m_shards[i].m_tree.countRange(low, high);
+	}
+
+	return total;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+size_t ShardedRBST<K, V, Hash, Storage, Random, Compare>::shardCount() const {
+	return m_shardCount;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::Scan ShardedRBST<K, V, Hash, Storage, Random, Compare>::scan() const {
+	return Scan(this);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+size_t ShardedRBST<K, V, Hash, Storage, Random, Compare>::defaultShardCount() {
+	return std::max<size_t>(std::thread::hardware_concurrency(), 4);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::Shard& ShardedRBST<K, V, Hash, Storage, Random, Compare>::shardFor(const K& key) const {
+	return m_shards[shardIndex(key)];
+}
+
+// Hashes of integers are often the integers themselves, the Fibonacci multiplier spreads them over the high bits,
+// which multiply-shift maps to a shard without a division.
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+size_t ShardedRBST<K, V, Hash, Storage, Random, Compare>::shardIndex(const K& key) const {
+	const auto mixed = static_cast<uint64_t>(m_hash(key)) * 0x9e3779b97f4a7c15ull;
+	return static_cast<size_t>(((mixed >> 32) * m_shardCount) >> 32);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::MergeIterator(std::vector<Cursor> cursors, const Compare& compare) :
+    m_cursors(std::move(cursors)),
+    m_compare(compare)
+{
+	for (size_t i = 0; i < m_cursors.size(); ++i) {
+		if (m_cursors[i].first != m_cursors[i].second) {
+			m_heap.push_back(i);
+		}
+	}
+
+	std::make_heap(m_heap.begin(), m_heap.end(), [this](size_t lhs, size_t rhs) { return later(lhs, rhs); });
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator& ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::operator++() {
+	const auto heapOrder = [this](size_t lhs, size_t rhs) { return later(lhs, rhs); };
+	std::pop_heap(m_heap.begin(), m_heap.end(), heapOrder);
+
+	auto& cursor = m_cursors[m_heap.back()];
+	if (++cursor.first == cursor.second) {
+		m_heap.pop_back();
+	} else {
+		std::push_heap(m_heap.begin(), m_heap.end(), heapOrder);
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::operator++(int) {
+	auto tmp = *this;
+	++*this;
+	return tmp;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+bool ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::operator==(const MergeIterator& other) const {
+	if (m_heap.empty() || other.m_heap.empty()) {
+		return m_heap.empty() == other.m_heap.empty();
+	}
+
+	return top().first == other.top().first;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+bool ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::operator!=(const MergeIterator& other) const {
+	return !(*this == other);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+const typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::KVPair& ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::operator*() const {
+	return *top().first;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+const typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::KVPair* ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::operator->() const {
+	return &*top().first;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::operator bool() const {
+	return !m_heap.empty();
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+const typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::Cursor& ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::top() const {
+	return m_cursors[m_heap.front()];
+}
+
+// Equal keys are never in different shards, so ties between cursors do not occur.
+// The comparator is the one the shard trees were built with, so the merge agrees with their order.
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+bool ShardedRBST<K, V, Hash, Storage, Random, Compare>::MergeIterator::later(size_t lhs, size_t rhs) const {
+	return threeWayCompare(m_compare, m_cursors[rhs].first->first, m_cursors[lhs].first->first) < 0;
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+ShardedRBST<K, V, Hash, Storage, Random, Compare>::Scan::Scan(const ShardedRBST* tree) :
+    m_tree(tree)
+{
+	m_locks.reserve(tree->m_shardCount);
+	for (size_t i = 0; i < tree->m_shardCount; ++i) {
+		m_locks.emplace_back(tree->m_shards[i].m_mutex);
+	}
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::iterator ShardedRBST<K, V, Hash, Storage, Random, Compare>::Scan::begin() const {
+	std::vector<typename MergeIterator::Cursor> cursors;
+	for (size_t i = 0; i < m_tree->m_shardCount; ++i) {
+		const auto& shardTree = m_tree->m_shards[i].m_tree;
+		cursors.emplace_back(shardTree.begin(), shardTree.end());
+	}
+
+	return MergeIterator(std::move(cursors), m_tree->m_compare);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::iterator ShardedRBST<K, V, Hash, Storage, Random, Compare>::Scan::end() const {
+	return MergeIterator();
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+typename ShardedRBST<K, V, Hash, Storage, Random, Compare>::iterator ShardedRBST<K, V, Hash, Storage, Random, Compare>::Scan::lowerBound(const K& key) const {
+	std::vector<typename MergeIterator::Cursor> cursors;
+	for (size_t i = 0; i < m_tree->m_shardCount; ++i) {
+		const auto& shardTree = m_tree->m_shards[i].m_tree;
+		cursors.emplace_back(shardTree.lowerBound(key), shardTree.end());
+	}
+
+	return MergeIterator(std::move(cursors), m_tree->m_compare);
+}
+
+template <typename K, typename V, typename Hash, typename Storage, typename Random, typename Compare>
+size_t ShardedRBST<K, V, Hash, Storage, Random, Compare>::Scan::size() const {
+	auto total = size_t{ 0 };
+	for (size_t i = 0; i < m_tree->m_shardCount; ++i) {
+		total += m_tree->m_shards[i].m_tree.size();
+	}
+
+	return total;
+}
@@ -1,6 +1,84 @@
 #include "RBST.h"
+#include "CompactRBST.h"
+#include "PersistentRBST.h"
+#include "RcuRBST.h"
+#include "ConcurrentRBST.h"
+#include "ShardedRBST.h"
 
+#include <AnyBST.h>
+#include <FrozenTree.h>
+
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <random>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Counts comparisons, with or without a three-way compare().
+struct CountingLess {
+	bool operator()(int lhs, int rhs) const {
+		++*calls;
+		return lhs < rhs;
+	}
+
+	size_t* calls;
+};
+
+struct CountingThreeWay : CountingLess {
+	int compare(int lhs, int rhs) const {
+		++*calls;
+		return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+	}
+};
+
+// Comparator whose order is chosen at run time, copies must carry the direction.
+struct DirectedLess {
+	bool operator()(int lhs, int rhs) const {
+		return descending ? rhs < lhs : lhs < rhs;
+	}
+
+	bool descending{ false };
+};
+
+// Value type counting copies, for checking that insertion moves values into the nodes.
+struct CopyCounted {
+	CopyCounted(int value = 0) : value(value) {}
+	CopyCounted(const CopyCounted& other) : value(other.value) { ++copies; }
+	CopyCounted(CopyCounted&& other) noexcept : value(other.value) {}
+
+	CopyCounted& operator=(const CopyCounted& other) {
+		value = other.value;
+		++copies;
+		return *this;
+	}
+
+	CopyCounted& operator=(CopyCounted&& other) noexcept {
+		value = other.value;
+		return *this;
+	}
+
+	int value;
+
+	static size_t copies;
+};
+
+size_t CopyCounted::copies = 0;
+
+// Value type counting destructions, which may run on the reclamation thread.
+struct DestructionCounted {
+	~DestructionCounted() {
+		++destroyed;
+	}
+
+	static std::atomic<size_t> destroyed;
+};
+
+std::atomic<size_t> DestructionCounted::destroyed{ 0 };
 
 int main() {
 	RBST<int, std::string> tree;
@@ -80,6 +158,934 @@ int main() {
 
 	std::cout << "Large Insertion OK" << std::endl;
 
+	/* arena storage */
+
+	RBST<int, std::string, ArenaNodeStorage> arenaTree;
+
+	for (auto i = 0; i < 1000; ++i) {
+		arenaTree.insert(i, std::to_string(i));
+	}
+
+	for (auto i = 0; i < 1000; i += 2) {
+		const auto removed = arenaTree.remove(i);
+		assert(removed);
+	}
+
+	assert(arenaTree.size() == 500);
+
+	for (auto i = 0; i < 1000; ++i) {
+		assert(arenaTree.contains(i) == (i % 2 != 0));
+	}
+
+	arenaTree.clear();
+
+	for (auto i = 0; i < 100; ++i) {
+		arenaTree.insert(i, std::to_string(i));
+	}
+
+	for (auto i = 0; i < 100; ++i) {
+		assert(arenaTree.find(i)->second == std::to_string(i));
+	}
+
+	std::cout << "Arena storage OK" << std::endl;
+
+	/* compact node layout */
+
+	CompactRBST<int, std::string> compactTree;
+
+	for (auto i = 0; i < 1000; ++i) {
+		compactTree.insert(i, std::to_string(i));
+	}
+
+	for (auto i = 0; i < 1000; i += 2) {
+		const auto removed = compactTree.remove(i);
+		assert(removed);
+	}
+
+	const auto removedTwice = compactTree.remove(0);
+	assert(!removedTwice);
+	assert(compactTree.size() == 500);
+
+	for (auto i = 0; i < 1000; ++i) {
+		assert(compactTree.contains(i) == (i % 2 != 0));
+	}
+
+	for (auto i = 0; i < 1000; i += 2) {
+		compactTree.insert(i, std::to_string(i));
+	}
+
+	auto expectedKey = 0;
+	for (auto it = compactTree.cbegin(); it != compactTree.cend(); ++it) {
+		assert(it->first == expectedKey);
+		assert(it->second == std::to_string(expectedKey));
+		++expectedKey;
+	}
+
+	assert(expectedKey == 1000);
+
+	compactTree.clear();
+
+	assert(compactTree.size() == 0);
+	assert(compactTree.begin() == compactTree.end());
+
+	// Released slots hold no value, so values need no default constructor.
+	CompactRBST<int, std::reference_wrapper<const int>> referenceTree;
+	const auto referenced = 7;
+
+	for (auto i = 0; i < 100; ++i) {
+		referenceTree.insert(i, std::cref(referenced));
+	}
+
+	for (auto i = 0; i < 100; i += 2) {
+		const auto removed = referenceTree.remove(i);
+		assert(removed);
+	}
+
+	referenceTree.insert(200, std::cref(referenced));
+	assert(referenceTree.size() == 51 && referenceTree.contains(200) && referenceTree.begin()->second.get() == 7);
+
+	std::cout << "Compact layout OK" << std::endl;
+
+	/* seeded random source */
+
+	const auto printedTree = [](const auto& t) {
+		std::ostringstream out;
+		auto* oldBuffer = std::cout.rdbuf(out.rdbuf());
+		t.printTree();
+		std::cout.rdbuf(oldBuffer);
+		return out.str();
+	};
+
+	RBST<int, std::string> seededTree1(42);
+	RBST<int, std::string> seededTree2;
+	seededTree2.seed(42);
+
+	for (auto i = 0; i < 200; ++i) {
+		seededTree1.insert(i, std::to_string(i));
+		seededTree2.insert(i, std::to_string(i));
+	}
+
+	for (auto i = 0; i < 200; i += 3) {
+		seededTree1.remove(i);
+		seededTree2.remove(i);
+	}
+
+	assert(printedTree(seededTree1) == printedTree(seededTree2));
+
+	RBST<int, std::string, SharedNodeStorage, DeviceRandom> deviceTree;
+
+	for (auto i = 0; i < 100; ++i) {
+		deviceTree.insert(i, std::to_string(i));
+	}
+
+	for (auto i = 0; i < 100; ++i) {
+		assert(deviceTree.find(i)->second == std::to_string(i));
+	}
+
+	std::cout << "Random source OK" << std::endl;
+
+	/* bulk load */
+
+	std::vector<std::pair<int, std::string>> sortedItems;
+	for (auto i = 0; i < 1000; ++i) {
+		sortedItems.emplace_back(i, std::to_string(i));
+	}
+
+	RBST<int, std::string> bulkTree(sortedItems.cbegin(), sortedItems.cend());
+
+	assert(bulkTree.size() == 1000);
+
+	for (auto i = 0; i < 1000; ++i) {
+		assert(bulkTree.find(i)->second == std::to_string(i));
+	}
+
+	auto shuffledItems = sortedItems;
+	std::shuffle(shuffledItems.begin(), shuffledItems.end(), std::mt19937(1));
+
+	RBST<int, std::string, ArenaNodeStorage> unsortedBulkTree(shuffledItems.cbegin(), shuffledItems.cend());
+
+	assert(unsortedBulkTree.size() == 1000);
+
+	for (auto i = 0; i < 1000; i += 2) {
+		const auto removed = unsortedBulkTree.remove(i);
+		assert(removed);
+	}
+
+	for (auto i = 1000; i < 1100; ++i) {
+		unsortedBulkTree.insert(i, std::to_string(i));
+	}
+
+	assert(unsortedBulkTree.size() == 600);
+
+	for (auto i = 0; i < 1100; ++i) {
+		assert(unsortedBulkTree.contains(i) == (i >= 1000 || i % 2 != 0));
+	}
+
+	bulkTree.assignSorted(sortedItems.cbegin(), sortedItems.cbegin() + 10);
+
+	assert(bulkTree.size() == 10);
+	assert(!bulkTree.contains(10));
+
+	std::cout << "Bulk load OK" << std::endl;
+
+	/* order statistics */
+
+	RBST<int, std::string> statTree;
+	for (const auto& item : shuffledItems) {
+		statTree.insert(item.first * 2, item.second);
+	}
+
+	for (auto i = 0; i < 1000; ++i) {
+		assert(statTree.select(static_cast<size_t>(i))->first == i * 2);
+		assert(statTree.rank(i * 2) == static_cast<size_t>(i));
+		assert(statTree.rank(i * 2 + 1) == static_cast<size_t>(i + 1));
+	}
+
+	assert(!statTree.select(1000));
+	assert(statTree.rank(-1) == 0);
+	assert(statTree.countRange(0, 1998) == 1000);
+	assert(statTree.countRange(10, 20) == 6);
+	assert(statTree.countRange(11, 19) == 4);
+	assert(statTree.countRange(20, 10) == 0);
+	assert(statTree.countRange(5000, 6000) == 0);
+
+	for (auto i = 0; i < 1000; i += 2) {
+		statTree.remove(i * 2);
+	}
+
+	assert(statTree.select(0)->first == 2);
+	assert(statTree.rank(100) == 25);
+	assert(statTree.countRange(0, 1998) == 500);
+
+	std::cout << "Order statistics OK" << std::endl;
+
+	/* range queries */
+
+	RBST<int, std::string> rangeTree;
+	for (auto i = 0; i < 100; ++i) {
+		rangeTree.insert(i * 2, std::to_string(i * 2));
+	}
+
+	assert(rangeTree.lowerBound(10)->first == 10);
+	assert(rangeTree.lowerBound(11)->first == 12);
+	assert(rangeTree.upperBound(10)->first == 12);
+	assert(rangeTree.upperBound(198) == rangeTree.end());
+	assert(rangeTree.lowerBound(-5)->first == 0);
+	assert(rangeTree.floor(11)->first == 10);
+	assert(rangeTree.floor(10)->first == 10);
+	assert(!rangeTree.floor(-1));
+	assert(rangeTree.ceiling(11)->first == 12);
+	assert(!rangeTree.ceiling(199));
+
+	const auto equal = rangeTree.equalRange(20);
+	assert(equal.first->first == 20);
+	assert(equal.second->first == 22);
+	assert(rangeTree.equalRange(21).first == rangeTree.equalRange(21).second);
+
+	auto expectedRangeKey = 10;
+	for (const auto& item : rangeTree.range(9, 31)) {
+		assert(item.first == expectedRangeKey);
+		expectedRangeKey += 2;
+	}
+
+	assert(expectedRangeKey == 32);
+	assert(rangeTree.range(31, 9).empty());
+	assert(rangeTree.range(199, 300).empty());
+
+	auto fullCount = 0;
+	for (const auto& item : rangeTree.range(0, 198)) {
+		assert(item.first == fullCount * 2);
+		++fullCount;
+	}
+
+	assert(fullCount == 100);
+
+	std::cout << "Range queries OK" << std::endl;
+
+	/* type-erased tree */
+
+	std::vector<AnyBST<int, std::string>> anyTrees;
+	anyTrees.emplace_back(RBST<int, std::string>(5));
+	anyTrees.emplace_back(RBST<int, std::string, ArenaNodeStorage>(5));
+	anyTrees.emplace_back(CompactRBST<int, std::string>(5));
+
+	for (auto& anyTree : anyTrees) {
+		for (auto k = 0; k < 50; ++k) {
+			anyTree.insert(49 - k, std::to_string(49 - k));
+		}
+
+		assert(anyTree.size() == 50);
+		assert(anyTree.contains(10));
+		assert(*anyTree.find(10) == "10");
+		assert(anyTree.find(50) == nullptr);
+
+		const auto removed = anyTree.remove(10);
+		const auto removedTwice = anyTree.remove(10);
+		assert(removed && !removedTwice);
+		assert(!anyTree.contains(10));
+
+		auto moved = std::move(anyTree);
+		assert(moved.size() == 49);
+		anyTree = std::move(moved);
+
+		auto previous = -1;
+		anyTree.forEach([&previous](const int& key, const std::string& value) {
+			assert(key > previous);
+			assert(value == std::to_string(key));
+			previous = key;
+		});
+		assert(previous == 49);
+	}
+
+	assert((anyTrees[0].target<RBST<int, std::string>>()->size() == 49));
+	assert((anyTrees[0].target<CompactRBST<int, std::string>>() == nullptr));
+	assert((anyTrees[2].target<CompactRBST<int, std::string>>() != nullptr));
+
+	std::cout << "Type-erased tree OK" << std::endl;
+
+	/* key comparators */
+
+	RBST<std::string, int, SharedNodeStorage, XoshiroRandom, ThreeWayCompare<>> stringTree;
+	for (auto k = 0; k < 100; ++k) {
+		stringTree.insert("key" + std::to_string(k + 100), k);
+	}
+
+	const auto viewKey = std::string_view("key150");
+	assert(stringTree.contains(viewKey));
+	assert(stringTree.find(viewKey)->second == 50);
+	assert(stringTree.find("key199")->second == 99);
+	assert(stringTree.find(std::string_view("key99")) == stringTree.end());
+	assert(stringTree.lowerBound(std::string_view("key1505"))->first == "key151");
+	assert(stringTree.upperBound("key150")->first == "key151");
+	assert(stringTree.floor(std::string_view("key1505"))->first == "key150");
+	assert(stringTree.rank("key150") == 50);
+
+	RBST<int, int, SharedNodeStorage, XoshiroRandom, std::greater<int>> descendingTree;
+	for (auto k = 0; k < 20; ++k) {
+		descendingTree.insert(k, k);
+	}
+
+	auto descendingKey = 19;
+	for (const auto& item : descendingTree) {
+		assert(item.first == descendingKey);
+		--descendingKey;
+	}
+
+	assert(descendingKey == -1);
+
+	assert(descendingTree.lowerBound(5)->first == 5);
+	assert(descendingTree.upperBound(5)->first == 4);
+	assert(descendingTree.countRange(15, 10) == 6);
+
+	const auto removedSeven = descendingTree.remove(7);
+	assert(removedSeven && !descendingTree.contains(7));
+
+	size_t lessCalls = 0;
+	size_t threeWayCalls = 0;
+	RBST<int, int, SharedNodeStorage, XoshiroRandom, CountingLess> lessTree(CountingLess{ &lessCalls });
+	RBST<int, int, SharedNodeStorage, XoshiroRandom, CountingThreeWay> threeWayTree(CountingThreeWay{ { &threeWayCalls } });
+	lessTree.seed(9);
+	threeWayTree.seed(9);
+
+	for (auto k = 0; k < 1000; ++k) {
+		lessTree.insert((k * 7919) % 1000, k);
+		threeWayTree.insert((k * 7919) % 1000, k);
+	}
+
+	lessCalls = 0;
+	threeWayCalls = 0;
+	for (auto k = 0; k < 1000; ++k) {
+		assert(lessTree.contains(k));
+		assert(threeWayTree.contains(k));
+	}
+
+	assert(threeWayCalls < lessCalls);
+
+	std::cout << "Key comparators OK" << std::endl;
+
+	/* move-aware insertion */
+
+	RBST<int, CopyCounted> countedTree;
+	countedTree.insert(1, CopyCounted(10));
+	countedTree.emplace(2, 20);
+	assert(CopyCounted::copies == 0);
+
+	auto tried = countedTree.tryEmplace(2, 21);
+	assert(!tried.second && tried.first->second.value == 20);
+	tried = countedTree.tryEmplace(3, 30);
+	assert(tried.second && tried.first->second.value == 30);
+
+	auto assigned = countedTree.insertOrAssign(1, CopyCounted(11));
+	assert(!assigned.second && assigned.first->second.value == 11);
+	assigned = countedTree.insertOrAssign(4, CopyCounted(40));
+	assert(assigned.second && countedTree.find(4)->second.value == 40);
+
+	assert(countedTree.size() == 4);
+	assert(CopyCounted::copies == 0);
+
+	const auto countedValue = CopyCounted(50);
+	countedTree.insert(5, countedValue);
+	assert(CopyCounted::copies == 1);
+
+	RBST<std::string, std::unique_ptr<int>, ArenaNodeStorage> ownerTree;
+	ownerTree.insert("one", std::make_unique<int>(1));
+	ownerTree.emplace("two", std::make_unique<int>(2));
+
+	const auto ownerTried = ownerTree.tryEmplace("two", std::make_unique<int>(3));
+	assert(!ownerTried.second && *ownerTree.find("two")->second == 2);
+	const auto ownerAssigned = ownerTree.insertOrAssign("two", std::make_unique<int>(4));
+	assert(!ownerAssigned.second && *ownerTree.find("two")->second == 4);
+	assert(ownerTree.size() == 2);
+
+	std::cout << "Move-aware insertion OK" << std::endl;
+
+	/* upsert and extract */
+
+	RBST<std::string, int> counterTree;
+	const std::vector<std::string> words = { "b", "a", "c", "a", "b", "a" };
+	for (const auto& word : words) {
+		counterTree.upsert(word, [](int& count) { ++count; });
+	}
+
+	assert(counterTree.size() == 3);
+	assert(counterTree.find("a")->second == 3);
+	assert(counterTree.find("b")->second == 2);
+
+	const auto upserted = counterTree.upsert("c", [](int& count) { count *= 10; });
+	assert(!upserted.second && counterTree.find("c")->second == 10);
+
+	auto computed = counterTree.compute("d", [](std::optional<int>& count) {
+		assert(!count);
+		count = 4;
+	});
+	assert(computed->first == "d" && computed->second == 4);
+
+	computed = counterTree.compute("a", [](std::optional<int>& count) {
+		assert(count && *count == 3);
+		count.reset();
+	});
+	assert(computed == counterTree.end());
+	assert(!counterTree.contains("a") && counterTree.size() == 3);
+
+	computed = counterTree.compute("e", [](std::optional<int>&) {});
+	assert(computed == counterTree.end() && counterTree.size() == 3);
+
+	const auto extracted = counterTree.extract("b");
+	const auto extractedTwice = counterTree.extract("b");
+	assert(extracted && *extracted == 2);
+	assert(!extractedTwice);
+	assert(counterTree.size() == 2);
+	assert(counterTree.begin()->first == "c");
+
+	std::cout << "Upsert and extract OK" << std::endl;
+
+	/* node handles and merge */
+
+	RBST<int, std::string> evenTree(3);
+	RBST<int, std::string> oddTree(4);
+	for (auto k = 0; k < 200; ++k) {
+		(k % 2 ? oddTree : evenTree).insert(k, std::to_string(k));
+	}
+
+	auto handle = oddTree.extractNode(51);
+	assert(handle && handle.key() == 51 && handle.value() == "51");
+	assert(!oddTree.contains(51) && oddTree.size() == 99);
+
+	const auto missingHandle = oddTree.extractNode(51);
+	assert(missingHandle.empty());
+
+	handle.value() = "moved";
+	const auto* movedNodeValue = &handle.value();
+	const auto handleIt = evenTree.insert(std::move(handle));
+	assert(handle.empty());
+	assert(handleIt->first == 51 && &handleIt->second == movedNodeValue);
+	assert(evenTree.size() == 101);
+
+	oddTree.insert(0, "duplicate");
+	evenTree.merge(oddTree);
+	assert(oddTree.size() == 0 && oddTree.begin() == oddTree.end());
+	assert(evenTree.size() == 201);
+	assert(evenTree.find(51)->second == "moved");
+
+	auto mergedKey = 0;
+	for (auto it = evenTree.begin(); it != evenTree.end(); ++it) {
+		if (mergedKey == 1) {
+			assert(it->first == 0 && it->second == "duplicate");
+		} else {
+			assert(it->first == std::max(mergedKey - 1, 0));
+		}
+		++mergedKey;
+	}
+	assert(mergedKey == 201);
+
+	RBST<int, std::string, ArenaNodeStorage> arenaTarget;
+	RBST<int, std::string, ArenaNodeStorage> arenaSource;
+	for (auto k = 0; k < 50; ++k) {
+		arenaTarget.insert(2 * k, "even");
+		arenaSource.insert(2 * k + 1, "odd");
+	}
+
+	arenaTarget.insert(arenaSource.extractNode(7));
+	assert(arenaTarget.find(7)->second == "odd");
+	{
+		auto dropped = arenaSource.extractNode(9);
+		assert(dropped);
+	}
+	arenaTarget.merge(arenaSource);
+	assert(arenaSource.size() == 0 && arenaTarget.size() == 99);
+	assert(arenaTarget.rank(50) == 49 && !arenaTarget.contains(9));
+
+	std::cout << "Node handles and merge OK" << std::endl;
+
+	/* set operations */
+
+	RBST<int, int> multiplesOfTwo(5);
+	RBST<int, int> multiplesOfThree(6);
+	for (auto k = 0; k < 3000; ++k) {
+		if (k % 2 == 0) {
+			multiplesOfTwo.insert(k, 2);
+		}
+		if (k % 3 == 0) {
+			multiplesOfThree.insert(k, 3);
+		}
+	}
+
+	auto copied = multiplesOfTwo;
+	copied.insert(1, 1);
+	assert(copied.size() == 1501 && multiplesOfTwo.size() == 1500 && !multiplesOfTwo.contains(1));
+
+	for (const auto cutoff : { RBST<int, int>::sequential, size_t(64) }) {
+		auto united = multiplesOfTwo;
+		united.unionWith(multiplesOfThree, cutoff);
+		assert(united.size() == 2000 && multiplesOfThree.size() == 1000);
+		assert(united.find(6)->second == 2 && united.find(9)->second == 3 && !united.contains(1));
+
+		auto common = multiplesOfTwo;
+		common.intersectWith(multiplesOfThree, cutoff);
+		assert(common.size() == 500);
+		assert(std::all_of(common.begin(), common.end(), [](const auto& keyValue) { return keyValue.first % 6 == 0; }));
+
+		auto evenOnly = multiplesOfTwo;
+		evenOnly.differenceWith(multiplesOfThree, cutoff);
+		assert(evenOnly.size() == 1000 && !evenOnly.contains(6) && evenOnly.contains(4));
+		assert(std::is_sorted(evenOnly.begin(), evenOnly.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; }));
+	}
+
+	auto upperHalf = multiplesOfThree.split(1499);
+	assert(multiplesOfThree.size() == 500 && upperHalf.size() == 500);
+	assert(multiplesOfThree.floor(2999)->first == 1497 && upperHalf.begin()->first == 1500);
+
+	RBST<int, int, ArenaNodeStorage> arenaLeft;
+	RBST<int, int, ArenaNodeStorage> arenaRight;
+	for (auto k = 0; k < 100; ++k) {
+		arenaLeft.insert(k, k);
+		arenaRight.insert(k + 50, k);
+	}
+
+	auto arenaUpper = arenaLeft.split(74);
+	arenaLeft.differenceWith(arenaRight, 1);
+	arenaUpper.intersectWith(arenaRight);
+	assert(arenaLeft.size() == 50 && arenaUpper.size() == 25 && arenaUpper.begin()->first == 75);
+
+	std::cout << "Set operations OK" << std::endl;
+
+	/* batch insertion and removal */
+
+	RBST<int, int> batchTree(7);
+	for (auto k = 0; k < 100; ++k) {
+		batchTree.insert(k, 0);
+	}
+
+	std::vector<std::pair<int, int>> batch;
+	for (auto k = 299; k >= 50; --k) {
+		batch.emplace_back(k, 1);
+	}
+
+	const auto countKey = [&batchTree](int key) {
+		const auto range = batchTree.equalRange(key);
+		return std::distance(range.first, range.second);
+	};
+
+	batchTree.multiInsert(batch.cbegin(), batch.cend());
+	assert(batchTree.size() == 350 && countKey(50) == 2 && countKey(150) == 1);
+	assert(std::next(batchTree.lowerBound(99))->second == 1);
+
+	batchTree.multiInsert(batch.cbegin(), batch.cend(), 16);
+	assert(batchTree.size() == 600 && countKey(150) == 2);
+
+	const std::vector<int> removedKeys = { 299, 0, 50, 50, 1000, 150 };
+	const auto removedCount = batchTree.multiRemove(removedKeys.cbegin(), removedKeys.cend());
+	assert(removedCount == 8);
+	assert(batchTree.size() == 592 && !batchTree.contains(50) && !batchTree.contains(0) && batchTree.contains(51));
+
+	std::vector<int> everyKey;
+	for (auto k = 0; k < 300; ++k) {
+		everyKey.push_back(k);
+	}
+
+	const auto removedEvery = batchTree.multiRemove(everyKey.cbegin(), everyKey.cend(), 16);
+	assert(removedEvery == 592);
+	assert(batchTree.size() == 0 && batchTree.begin() == batchTree.end());
+
+	std::cout << "Batch insertion and removal OK" << std::endl;
+
+	/* range erase */
+
+	RBST<int, std::string> timeline(8);
+	for (auto k = 0; k < 1000; ++k) {
+		timeline.insert(k, std::to_string(k));
+	}
+
+	const auto erased = timeline.eraseRange(100, 199);
+	assert(erased == 100);
+	assert(timeline.size() == 900 && !timeline.contains(100) && !timeline.contains(199));
+	assert(timeline.contains(99) && timeline.contains(200));
+
+	const auto erasedAgain = timeline.eraseRange(150, 160);
+	const auto erasedReversed = timeline.eraseRange(10, 5);
+	assert(erasedAgain == 0 && erasedReversed == 0);
+
+	auto expired = timeline.extractRange(-5, 49);
+	assert(expired.size() == 50 && expired.begin()->first == 0 && expired.find(49)->second == "49");
+	assert(timeline.size() == 850 && timeline.begin()->first == 50);
+
+	RBST<int, std::string, ArenaNodeStorage> arenaTimeline;
+	for (auto k = 0; k < 100; ++k) {
+		arenaTimeline.insert(k, std::to_string(k));
+	}
+
+	auto arenaExpired = arenaTimeline.extractRange(90, 200);
+	const auto arenaErased = arenaTimeline.eraseRange(0, 9);
+	assert(arenaErased == 10);
+	assert(arenaExpired.size() == 10 && arenaTimeline.size() == 80);
+	assert(arenaExpired.find(95)->second == "95" && arenaTimeline.rank(50) == 40);
+
+	std::cout << "Range erase OK" << std::endl;
+
+	/* deferred destruction */
+
+	{
+		RBST<int, DestructionCounted, DeferredNodeStorage> deferredTree;
+		for (auto k = 0; k < 1000; ++k) {
+			deferredTree.tryEmplace(k);
+		}
+
+		const auto deferredErased = deferredTree.eraseRange(0, 99);
+		assert(deferredErased == 100);
+		NodeReclaimer::instance().drain();
+		assert(DestructionCounted::destroyed == 100);
+
+		deferredTree.clear();
+		assert(deferredTree.size() == 0 && deferredTree.begin() == deferredTree.end());
+
+		for (auto k = 0; k < 100; ++k) {
+			deferredTree.tryEmplace(k);
+		}
+	}
+
+	NodeReclaimer::instance().drain();
+	assert(DestructionCounted::destroyed == 1100);
+
+	std::cout << "Deferred destruction OK" << std::endl;
+
+	/* persistent snapshots */
+
+	PersistentRBST<int, std::shared_ptr<int>> persistentTree(9);
+	for (auto k = 0; k < 1000; ++k) {
+		persistentTree.insert(k, std::make_shared<int>(k));
+	}
+
+	auto version = persistentTree.snapshot();
+	const auto tracked = *version.find(500)->second;
+	std::weak_ptr<int> trackedValue = version.find(500)->second;
+
+	const auto removedFromTree = persistentTree.remove(500);
+	const auto removedTwiceFromTree = persistentTree.remove(500);
+	assert(removedFromTree && !removedTwiceFromTree);
+	persistentTree.insert(1000, std::make_shared<int>(1000));
+	persistentTree.insert(-1, std::make_shared<int>(-1));
+
+	assert(persistentTree.size() == 1001 && !persistentTree.contains(500) && persistentTree.begin()->first == -1);
+	assert(version.size() == 1000 && version.contains(500) && !version.contains(1000) && version.begin()->first == 0);
+	assert(tracked == 500 && !trackedValue.expired());
+
+	auto snapshotKey = 0;
+	for (const auto& keyValue : version) {
+		assert(keyValue.first == snapshotKey && *keyValue.second == snapshotKey);
+		++snapshotKey;
+	}
+	assert(snapshotKey == 1000);
+	assert(version.lowerBound(250)->first == 250 && persistentTree.lowerBound(500)->first == 501);
+
+	version = decltype(version)();
+	assert(trackedValue.expired());
+
+	persistentTree.clear();
+	assert(persistentTree.size() == 0 && persistentTree.begin() == persistentTree.end());
+
+	std::cout << "Persistent snapshots OK" << std::endl;
+
+	/* concurrent updates */
+
+	ConcurrentRBST<int, int> concurrentTree;
+	const auto insertedOne = concurrentTree.insert(1, 10);
+	const auto insertedOneTwice = concurrentTree.insert(1, 20);
+	assert(insertedOne && !insertedOneTwice && *concurrentTree.find(1) == 10);
+
+	const auto removedOne = concurrentTree.remove(1);
+	const auto removedOneTwice = concurrentTree.remove(1);
+	assert(removedOne && !removedOneTwice && !concurrentTree.find(1));
+
+	// Every thread owns the keys congruent to its index modulo the thread count.
+	const auto updateThreads = 4;
+	std::vector<std::thread> updaters;
+	for (auto t = 0; t < updateThreads; ++t) {
+		updaters.emplace_back([&concurrentTree, t] {
+			for (auto k = t; k < 8000; k += updateThreads) {
+				concurrentTree.insert(k, -k);
+			}
+
+			for (auto k = t; k < 8000; k += 2 * updateThreads) {
+				concurrentTree.remove(k);
+			}
+		});
+	}
+
+	for (auto& updater : updaters) {
+		updater.join();
+	}
+
+	// The second pass removed the keys whose remainder modulo twice the thread count is below the thread count.
+	auto previousKey = -1;
+	concurrentTree.forEach([&previousKey](int key, int value) {
+		assert(key > previousKey && key % (2 * updateThreads) >= updateThreads && value == -key);
+		previousKey = key;
+	});
+
+	assert(concurrentTree.size() == 4000 && !concurrentTree.contains(8) && *concurrentTree.find(7999) == -7999);
+
+	std::cout << "Concurrent updates OK" << std::endl;
+
+	/* epoch reclamation */
+
+	// A reader pinned on another thread holds the epoch back: nothing retired meanwhile may be freed,
+	// and retiring stays cheap although the retired list keeps growing.
+	std::atomic<int> readerState{ 0 };
+	std::thread pinnedReader([&readerState] {
+		const auto guard = EpochReclaimer::instance().pin();
+		readerState = 1;
+
+		while (readerState != 2) {
+			std::this_thread::yield();
+		}
+	});
+
+	while (readerState != 1) {
+		std::this_thread::yield();
+	}
+
+	const auto destroyedBeforeRetire = DestructionCounted::destroyed.load();
+	for (auto i = 0; i < 20000; ++i) {
+		EpochReclaimer::instance().retire(new DestructionCounted());
+	}
+
+	assert(DestructionCounted::destroyed == destroyedBeforeRetire);
+
+	readerState = 2;
+	pinnedReader.join();
+
+	for (auto i = 0; i < 3; ++i) {
+		EpochReclaimer::instance().collect();
+	}
+
+	assert(DestructionCounted::destroyed == destroyedBeforeRetire + 20000);
+
+	std::cout << "Epoch reclamation OK" << std::endl;
+
+	/* sharded tree */
+
+	ShardedRBST<int, int> shardedTree(8);
+	assert(shardedTree.shardCount() == 8);
+
+	std::vector<std::thread> shardWriters;
+	for (auto t = 0; t < 4; ++t) {
+		shardWriters.emplace_back([&shardedTree, t] {
+			for (auto k = t; k < 4000; k += 4) {
+				shardedTree.insert(k, k);
+			}
+		});
+	}
+
+	for (auto& writer : shardWriters) {
+		writer.join();
+	}
+
+	assert(shardedTree.size() == 4000 && shardedTree.rank(1000) == 1000 && shardedTree.countRange(10, 19) == 10);
+
+	const auto assignedSeven = shardedTree.insertOrAssign(7, -7);
+	const auto removedEight = shardedTree.remove(8);
+	assert(!assignedSeven && *shardedTree.find(7) == -7 && removedEight && !shardedTree.contains(8));
+
+	std::vector<std::pair<int, int>> shardBatch;
+	for (auto k = 4000; k < 5000; ++k) {
+		shardBatch.emplace_back(k, k);
+	}
+	shardedTree.multiInsert(shardBatch.cbegin(), shardBatch.cend());
+
+	{
+		const auto scan = shardedTree.scan();
+		assert(scan.size() == 4999 && scan.lowerBound(8)->first == 9 && scan.lowerBound(5000) == scan.end());
+
+		auto scannedKey = 0;
+		for (const auto& keyValue : scan) {
+			scannedKey += scannedKey == 8 ? 1 : 0;
+			assert(keyValue.first == scannedKey && keyValue.second == (scannedKey == 7 ? -7 : scannedKey));
+			++scannedKey;
+		}
+		assert(scannedKey == 5000);
+	}
+
+	shardedTree.clear();
+	assert(shardedTree.size() == 0 && !shardedTree.scan().begin());
+
+	// Scans merge the shards by the comparator the shards were built with.
+	ShardedRBST<int, int, std::hash<int>, SharedNodeStorage, XoshiroRandom, DirectedLess> descendingShards(4, DirectedLess{ true });
+	for (auto k = 0; k < 100; ++k) {
+		descendingShards.insert(k, k);
+	}
+
+	{
+		const auto scan = descendingShards.scan();
+		auto scannedKey = 99;
+		for (const auto& keyValue : scan) {
+			assert(keyValue.first == scannedKey);
+			--scannedKey;
+		}
+
+		assert(scannedKey == -1 && scan.lowerBound(50)->first == 50 && (++scan.lowerBound(50))->first == 49);
+	}
+
+	std::cout << "Sharded tree OK" << std::endl;
+
+	/* read-copy-update tree */
+
+	RcuRBST<int, int> rcuTree(11);
+	for (auto k = 0; k < 1000; ++k) {
+		rcuTree.insert(k, k);
+	}
+
+	assert(rcuTree.size() == 1000 && !rcuTree.contains(0));
+	rcuTree.publish();
+	assert(rcuTree.contains(0) && *rcuTree.find(999) == 999);
+
+	{
+		const auto rcuView = rcuTree.read();
+
+		const auto removedFromRcu = rcuTree.remove(500);
+		const auto removedTwiceFromRcu = rcuTree.remove(500);
+		const auto insertedSeven = rcuTree.insertOrAssign(7, -7);
+		const auto insertedThousand = rcuTree.insertOrAssign(1000, 1000);
+		assert(removedFromRcu && !removedTwiceFromRcu && !insertedSeven && insertedThousand);
+		rcuTree.publish();
+
+		assert(rcuView.size() == 1000 && rcuView.contains(500) && rcuView.find(7)->second == 7 && !rcuView.contains(1000));
+		assert(!rcuTree.contains(500) && *rcuTree.find(7) == -7 && rcuTree.contains(1000));
+
+		auto rcuKey = 0;
+		for (const auto& keyValue : rcuView) {
+			assert(keyValue.first == rcuKey && keyValue.second == rcuKey);
+			++rcuKey;
+		}
+		assert(rcuKey == 1000 && rcuView.lowerBound(250)->first == 250);
+	}
+
+	std::atomic<bool> rcuWriting{ true };
+	std::thread rcuReader([&rcuTree, &rcuWriting] {
+		while (rcuWriting) {
+			assert(*rcuTree.find(0) == 0 && rcuTree.read().begin()->first == 0);
+		}
+	});
+
+	for (auto batch = 0; batch < 100; ++batch) {
+		for (auto k = 1; k < 1000; k += 7) {
+			rcuTree.remove(k);
+			rcuTree.insert(k, k);
+		}
+		rcuTree.publish();
+	}
+
+	rcuWriting = false;
+	rcuReader.join();
+
+	rcuTree.clear();
+	assert(rcuTree.size() == 0 && rcuTree.contains(0));
+	rcuTree.publish();
+	assert(!rcuTree.contains(0) && rcuTree.read().begin() == rcuTree.read().end());
+
+	std::cout << "Read-copy-update tree OK" << std::endl;
+
+	/* frozen tree */
+
+	RBST<int, int> unfrozenTree(21);
+	for (auto k = 0; k < 1000; ++k) {
+		unfrozenTree.insert(2 * k, k);
+	}
+	unfrozenTree.insert(500, -1);
+
+	const auto frozenTree = freeze(unfrozenTree);
+	assert(frozenTree.size() == 1001 && std::equal(frozenTree.begin(), frozenTree.end(), unfrozenTree.begin()));
+
+	for (auto key = -1; key <= 2000; ++key) {
+		assert(frozenTree.rank(key) == unfrozenTree.rank(key));
+		assert(frozenTree.contains(key) == unfrozenTree.contains(key));
+		assert(frozenTree.lowerBound(key) == std::lower_bound(frozenTree.begin(), frozenTree.end(), key, [](const auto& keyValue, int bound) {
+			return keyValue.first < bound;
+		}));
+		assert(frozenTree.upperBound(key) == std::upper_bound(frozenTree.begin(), frozenTree.end(), key, [](int bound, const auto& keyValue) {
+			return bound < keyValue.first;
+		}));
+	}
+
+	// Equal keys keep their order, find and lowerBound return the first of them.
+	assert(frozenTree.find(500)->second == 250 && std::next(frozenTree.find(500))->second == -1);
+	assert(frozenTree.upperBound(500) - frozenTree.lowerBound(500) == 2 && frozenTree.find(3) == frozenTree.end());
+
+	const FrozenTree<int, int> emptyFrozenTree;
+	assert(emptyFrozenTree.empty() && emptyFrozenTree.find(0) == emptyFrozenTree.end() && emptyFrozenTree.rank(0) == 0);
+
+	std::vector<std::pair<std::string, int>> frozenWords{ { "alpha", 1 }, { "beta", 2 }, { "gamma", 3 } };
+	const FrozenTree<std::string, int> frozenStrings(frozenWords.cbegin(), frozenWords.cend());
+	assert(frozenStrings.find("beta")->second == 2 && frozenStrings.rank("delta") == 2 && !frozenStrings.contains("omega"));
+
+	std::cout << "Frozen tree OK" << std::endl;
+
+	/* van Emde Boas layout */
+
+	const auto blockedTree = freeze<VanEmdeBoasLayout>(unfrozenTree);
+	assert(blockedTree.size() == 1001 && std::equal(blockedTree.begin(), blockedTree.end(), unfrozenTree.begin()));
+
+	for (auto key = -1; key <= 2000; ++key) {
+		assert(blockedTree.rank(key) == frozenTree.rank(key));
+		assert(blockedTree.find(key) - blockedTree.begin() == frozenTree.find(key) - frozenTree.begin());
+		assert(blockedTree.upperBound(key) - blockedTree.begin() == frozenTree.upperBound(key) - frozenTree.begin());
+	}
+
+	// Every height, complete or not.
+	for (auto count = 0; count <= 300; ++count) {
+		std::vector<std::pair<int, int>> evenKeys;
+		for (auto k = 0; k < count; ++k) {
+			evenKeys.emplace_back(2 * k, k);
+		}
+
+		const FrozenTree<int, int, ThreeWayCompare<int>, VanEmdeBoasLayout> evenTree(evenKeys.cbegin(), evenKeys.cend());
+		for (auto key = -1; key <= 2 * count; ++key) {
+			assert(evenTree.rank(key) == static_cast<size_t>((key + 1) / 2));
+			assert(evenTree.contains(key) == (key >= 0 && key < 2 * count && key % 2 == 0));
+		}
+	}
+
+	std::cout << "van Emde Boas layout OK" << std::endl;
+
 	tree.clear();
 
 	for (auto i = 0; i < 15; ++i) {
@@ -95,11 +1101,34 @@ int main() {
 	size_t i = 0;
 	for (auto it = tree.cbegin(); it != tree.cend(); ++it) {
 		std::cout << it->first << " ";
+		assert(it->first == static_cast<int>(i));
 		assert(it->second == std::to_string(it->first * 2));
 		++i;
 	}
 
-	assert(i == tree.size()); // TODO BUG HERE
+	assert(i == tree.size());
+
+	auto backIt = tree.end();
+	for (auto expected = 14; expected >= 0; --expected) {
+		--backIt;
+		assert(backIt->first == expected);
+	}
+
+	assert(backIt == tree.begin());
+
+	auto midIt = tree.find(7);
+	++midIt;
+	assert(midIt->first == 8);
+	midIt--;
+	--midIt;
+	assert(midIt->first == 6);
+
+	RBST<int, std::string> duplicateTree;
+	for (auto d = 0; d < 3; ++d) {
+		duplicateTree.insert(1, "same");
+	}
+
+	assert(std::distance(duplicateTree.begin(), duplicateTree.end()) == 3);
 
 	std::cout << "Iterators test OK" << std::endl;
 
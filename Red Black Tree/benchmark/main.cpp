@@ -0,0 +1,141 @@
+#include "RedBlackTree.h"
+
+#include <RBST.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Results are accumulated here so the optimizer cannot drop the measured work.
+volatile size_t sink = 0;
+
+// Per-operation latencies in nanoseconds, each operation is timed on its own.
+class Latencies {
+public:
+	explicit Latencies(size_t operations);
+
+	template <typename F>
+	void measure(F&& fn);
+
+	void report(const std::string& name);
+
+private:
+	std::vector<double> m_samples;
+};
+
+Latencies::Latencies(size_t operations) {
+	m_samples.reserve(operations);
+}
+
+template <typename F>
+void Latencies::measure(F&& fn) {
+	const auto start = std::chrono::steady_clock::now();
+	fn();
+	const auto end = std::chrono::steady_clock::now();
+	m_samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+}
+
+void Latencies::report(const std::string& name) {
+	std::sort(m_samples.begin(), m_samples.end());
+
+	const auto percentile = [this](double fraction) {
+		return m_samples[std::min(static_cast<size_t>(fraction * static_cast<double>(m_samples.size())), m_samples.size() - 1)];
+	};
+
+	std::cout << "  " << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(0)
+	          << std::setw(10) << percentile(0.5) << std::setw(10) << percentile(0.99)
+	          << std::setw(10) << percentile(0.999) << std::setw(12) << m_samples.back() << std::endl;
+
+	m_samples.clear();
+}
+
+void header(const std::string& title) {
+	std::cout << title << ", ns per operation" << std::endl;
+	std::cout << "  " << std::left << std::setw(44) << "" << std::right
+	          << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << std::endl;
+}
+
+std::vector<int> shuffledKeys(size_t count, unsigned seed) {
+	std::vector<int> keys(count);
+	for (size_t i = 0; i < count; ++i) {
+		keys[i] = static_cast<int>(i);
+	}
+
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+	return keys;
+}
+
+// Inserts count keys, looks every one of them up and removes them again, in random order or in ascending order.
+template <typename Tree>
+void latencyBenchmark(const std::string& name, size_t count, bool ascending) {
+	auto keys = shuffledKeys(count, 7);
+	if (ascending) {
+		std::sort(keys.begin(), keys.end());
+	}
+
+	Tree tree;
+	Latencies latencies(count);
+
+	for (const auto key : keys) {
+		latencies.measure([&tree, key] { tree.insert(key, key); });
+	}
+
+	latencies.report(name + ", insert");
+
+	auto found = size_t{ 0 };
+	for (const auto key : shuffledKeys(count, 11)) {
+		latencies.measure([&tree, &found, key] { found += tree.contains(key) ? 1 : 0; });
+	}
+
+	sink = sink + found;
+	latencies.report(name + ", find");
+
+	for (const auto key : shuffledKeys(count, 13)) {
+		latencies.measure([&tree, key] { tree.remove(key); });
+	}
+
+	latencies.report(name + ", remove");
+}
+
+void randomOrderBenchmark(size_t count) {
+	header(std::to_string(count) + " int keys in random order");
+
+	latencyBenchmark<RBST<int, int>>("RBST", count, false);
+	latencyBenchmark<RedBlackTree<int, int>>("RedBlackTree", count, false);
+	latencyBenchmark<RBST<int, int, ArenaNodeStorage>>("RBST with ArenaNodeStorage", count, false);
+	latencyBenchmark<RedBlackTree<int, int, ArenaNodeStorage>>("RedBlackTree with ArenaNodeStorage", count, false);
+}
+
+void ascendingOrderBenchmark(size_t count) {
+	header(std::to_string(count) + " int keys inserted in ascending order");
+
+	latencyBenchmark<RBST<int, int>>("RBST", count, true);
+	latencyBenchmark<RedBlackTree<int, int>>("RedBlackTree", count, true);
+	latencyBenchmark<RBST<int, int, ArenaNodeStorage>>("RBST with ArenaNodeStorage", count, true);
+	latencyBenchmark<RedBlackTree<int, int, ArenaNodeStorage>>("RedBlackTree with ArenaNodeStorage", count, true);
+}
+
+}
+
+int main(int argc, char** argv) {
+	const auto scale = argc > 1 ? std::stod(argv[1]) : 1.0;
+	const auto scaled = [scale](size_t n) { return std::max<size_t>(static_cast<size_t>(static_cast<double>(n) * scale), 1); };
+	const auto section = std::string(argc > 2 ? argv[2] : "");
+	const auto selected = [&section](const std::string& name) { return section.empty() || section == name; };
+
+	if (selected("random")) {
+		randomOrderBenchmark(scaled(1000000));
+	}
+
+	if (selected("ascending")) {
+		ascendingOrderBenchmark(scaled(1000000));
+	}
+
+	return 0;
+}
@@ -0,0 +1,690 @@
+#pragma once
+
+#include <AbstractBST.h>
+#include <algorithm>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+// Red-black tree: insert, remove and lookups are O(log n) in the worst case and the height stays below 2 log2(n + 1)
+// for any order of keys, so latencies do not depend on random draws like those of RBST. Equal keys are kept
+// in insertion order. Rotations keep the subtree sizes, so the order statistics of AbstractBST apply unchanged.
+template <typename K, typename V, typename Storage = SharedNodeStorage, typename Compare = ThreeWayCompare<K>>
+class RedBlackTree : public AbstractBST<RedBlackTree<K, V, Storage, Compare>, K, V, std::bidirectional_iterator_tag, Storage, Compare> {
+public:
+	using AbstractBaseTree = AbstractBST<RedBlackTree<K, V, Storage, Compare>, K, V, std::bidirectional_iterator_tag, Storage, Compare>;
+	using AbstractBaseTree::find;
+
+	RedBlackTree() = default;
+	explicit RedBlackTree(const Compare& compare);
+
+	// Copies own their nodes, the structure and colours of other are reproduced node by node.
+	RedBlackTree(const RedBlackTree& other);
+	RedBlackTree(RedBlackTree&& other) noexcept = default;
+
+	RedBlackTree& operator=(const RedBlackTree& other);
+	RedBlackTree& operator=(RedBlackTree&& other) noexcept = default;
+
+	// Builds the tree from a range of key-value pairs, linear if the range is already sorted by key.
+	template <typename InputIt, typename = std::enable_if_t<!std::is_integral<InputIt>::value>>
+	RedBlackTree(InputIt first, InputIt last);
+
+	// Replaces the contents with a range of key-value pairs, sorting them by key first if needed.
+	template <typename InputIt>
+	void assign(InputIt first, InputIt last);
+
+	// Replaces the contents with a range already sorted by key in a single linear pass.
+	template <typename ForwardIt>
+	void assignSorted(ForwardIt first, ForwardIt last);
+
+	using iterator = typename AbstractBaseTree::iterator;
+
+	// Inserting always adds an element, equal keys are kept in insertion order.
+	void insert(const K& key, const V& value);
+	void insert(K&& key, V&& value);
+
+	// Constructs the key-value pair in place from args and inserts it.
+	template <typename... Args>
+	iterator emplace(Args&&... args);
+
+	// Constructs the value in place from args only if the key is not present yet.
+	template <typename... Args>
+	std::pair<iterator, bool> tryEmplace(const K& key, Args&&... args);
+	template <typename... Args>
+	std::pair<iterator, bool> tryEmplace(K&& key, Args&&... args);
+
+	// Assigns value to the element with the key, or inserts it if there is none.
+	template <typename M>
+	std::pair<iterator, bool> insertOrAssign(const K& key, M&& value);
+	template <typename M>
+	std::pair<iterator, bool> insertOrAssign(K&& key, M&& value);
+
+	bool remove(const K& key);
+
+	// Removes an element with key and returns its value.
+	std::optional<V> extract(const K& key);
+
+	// Number of nodes on the longest path from the root, at most 2 log2(n + 1). Visits every node.
+	size_t height() const;
+
+	// Number of black nodes on every path from the root to an empty subtree, which counts as one,
+	// or 0 if a red node has a red child, the root is red or two paths differ. Visits every node.
+	size_t blackHeight() const;
+
+	void printTree() const;
+
+private:
+	friend AbstractBaseTree;
+
+	struct Node final : public AbstractBaseTree::AbstractNode {
+		using AbstractBaseTree::AbstractNode::AbstractNode;
+
+		bool m_red{ true };
+	};
+
+	using NodePtr = typename Node::Ptr;
+
+	// Empty subtrees count as black.
+	static bool isRed(const NodePtr& node);
+	static void paint(const NodePtr& node, bool red);
+
+	void printBinaryTree(const std::string& prefix, const NodePtr& node, bool isLeft) const;
+	size_t subtreeHeight(const NodePtr& node) const;
+	size_t subtreeBlackHeight(const NodePtr& node) const;
+
+	void fixSize(const NodePtr& node);
+	void fixSizesUpwards(NodePtr node);
+
+	template <typename Key>
+	NodePtr find(const NodePtr& node, const Key& key) const;
+
+	template <typename... Args>
+	NodePtr emplaceNode(Args&&... args);
+
+	// Returns the node with key, or links the node made by create() where insert would put it, in a single descent.
+	template <typename Key, typename Create>
+	std::pair<NodePtr, bool> findOrInsert(const Key& key, Create&& create);
+
+	// The link holding node, the root link or a child link of parent.
+	NodePtr& linkOf(const NodePtr& node, const NodePtr& parent);
+
+	// Puts replacement, which may be empty, in place of node under parent.
+	void transplant(const NodePtr& node, const NodePtr& parent, const NodePtr& replacement);
+
+	void rotateLeft(NodePtr node);
+	void rotateRight(NodePtr node);
+
+	// Restores the colour rules after node was linked as a red leaf, at most two rotations.
+	void fixAfterInsert(NodePtr node);
+
+	// Restores the colour rules after a black node was taken out above node, which may be empty, under parent.
+	// At most three rotations.
+	void fixAfterRemove(NodePtr node, NodePtr parent);
+
+	template <typename Key>
+	NodePtr detach(const Key& key);
+	void unlinkNode(const NodePtr& node);
+
+	NodePtr cloneSubtree(const NodePtr& node);
+
+	// Colours a tree built from sorted items: the nodes on the deepest, incomplete level red and the others black.
+	void paintLevels(const NodePtr& node, size_t depth, size_t redDepth);
+};
+
+template <typename K, typename V, typename Storage, typename Compare>
+RedBlackTree<K, V, Storage, Compare>::RedBlackTree(const Compare& compare) :
+    AbstractBaseTree(compare)
+{
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+RedBlackTree<K, V, Storage, Compare>::RedBlackTree(const RedBlackTree& other) :
+    AbstractBaseTree(other.keyCompare())
+{
+	this->m_rootNode = cloneSubtree(other.m_rootNode);
+	this->m_size = other.m_size;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+RedBlackTree<K, V, Storage, Compare>& RedBlackTree<K, V, Storage, Compare>::operator=(const RedBlackTree& other) {
+	if (this != &other) {
+		this->clear();
+		this->m_compare = other.m_compare;
+		this->m_rootNode = cloneSubtree(other.m_rootNode);
+		this->m_size = other.m_size;
+	}
+
+	return *this;
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename InputIt, typename>
+RedBlackTree<K, V, Storage, Compare>::RedBlackTree(InputIt first, InputIt last) {
+	assign(first, last);
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename InputIt>
+void RedBlackTree<K, V, Storage, Compare>::assign(InputIt first, InputIt last) {
+	std::vector<typename AbstractBaseTree::KVPair> items(first, last);
+
+	const auto byKey = [this](const auto& lhs, const auto& rhs) {
+		return this->keyLess(lhs.first, rhs.first);
+	};
+
+	if (!std::is_sorted(items.cbegin(), items.cend(), byKey)) {
+		std::stable_sort(items.begin(), items.end(), byKey);
+	}
+
+	assignSorted(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename ForwardIt>
+void RedBlackTree<K, V, Storage, Compare>::assignSorted(ForwardIt first, ForwardIt last) {
+	assert(std::is_sorted(first, last, [this](const auto& lhs, const auto& rhs) { return this->keyLess(lhs.first, rhs.first); }));
+
+	this->clear();
+
+	const auto count = static_cast<size_t>(std::distance(first, last));
+	this->m_rootNode = this->template buildFromSorted<Node>(first, count);
+	this->m_size = count;
+
+	// The halving build fills every level above floor(log2(count + 1)) completely.
+	auto redDepth = size_t{ 0 };
+	while ((size_t{ 1 } << (redDepth + 1)) <= count + 1) {
+		++redDepth;
+	}
+
+	paintLevels(this->m_rootNode, 0, redDepth);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::insert(const K& key, const V& value) {
+	emplaceNode(key, value);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::insert(K&& key, V&& value) {
+	emplaceNode(std::move(key), std::move(value));
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename... Args>
+typename RedBlackTree<K, V, Storage, Compare>::iterator RedBlackTree<K, V, Storage, Compare>::emplace(Args&&... args) {
+	return this->makeIterator(emplaceNode(std::forward<Args>(args)...));
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename... Args>
+std::pair<typename RedBlackTree<K, V, Storage, Compare>::iterator, bool> RedBlackTree<K, V, Storage, Compare>::tryEmplace(const K& key, Args&&... args) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	});
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename... Args>
+std::pair<typename RedBlackTree<K, V, Storage, Compare>::iterator, bool> RedBlackTree<K, V, Storage, Compare>::tryEmplace(K&& key, Args&&... args) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	});
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename M>
+std::pair<typename RedBlackTree<K, V, Storage, Compare>::iterator, bool> RedBlackTree<K, V, Storage, Compare>::insertOrAssign(const K& key, M&& value) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, key, std::forward<M>(value));
+	});
+
+	if (!result.second) {
+		result.first->m_keyValue.second = std::forward<M>(value);
+	}
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename M>
+std::pair<typename RedBlackTree<K, V, Storage, Compare>::iterator, bool> RedBlackTree<K, V, Storage, Compare>::insertOrAssign(K&& key, M&& value) {
+	const auto result = findOrInsert(key, [&] {
+		return this->template createNode<Node>(std::in_place, std::move(key), std::forward<M>(value));
+	});
+
+	if (!result.second) {
+		result.first->m_keyValue.second = std::forward<M>(value);
+	}
+
+	return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+bool RedBlackTree<K, V, Storage, Compare>::remove(const K& key) {
+	auto node = detach(key);
+	if (!node) {
+		return false;
+	}
+
+	this->destroyNode(node);
+
+	return true;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+std::optional<V> RedBlackTree<K, V, Storage, Compare>::extract(const K& key) {
+	auto node = detach(key);
+	if (!node) {
+		return std::nullopt;
+	}
+
+	std::optional<V> value(std::move(node->m_keyValue.second));
+	this->destroyNode(node);
+
+	return value;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+size_t RedBlackTree<K, V, Storage, Compare>::height() const {
+	return subtreeHeight(this->m_rootNode);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+size_t RedBlackTree<K, V, Storage, Compare>::blackHeight() const {
+	return isRed(this->m_rootNode) ? 0 : subtreeBlackHeight(this->m_rootNode);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::printTree() const {
+	printBinaryTree("", this->m_rootNode, false);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+bool RedBlackTree<K, V, Storage, Compare>::isRed(const NodePtr& node) {
+	return node && static_cast<const Node&>(*node).m_red;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::paint(const NodePtr& node, bool red) {
+	static_cast<Node&>(*node).m_red = red;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::printBinaryTree(const std::string& prefix, const NodePtr& node, bool isLeft) const {
+	if (node) {
+		std::string parentStr;
+		const auto& strongParent = node->parent();
+		if (strongParent) {
+			parentStr = " (parent : ";
+			parentStr += std::to_string(strongParent->m_keyValue.first);
+			parentStr += ")";
+		}
+
+		std::cout	<< prefix.c_str()
+		            << (isLeft ? "├──" : "└──" )
+		            << " (" << node->m_keyValue.first
+		            << ", " << node->m_keyValue.second << ") "
+		            << (isRed(node) ? "red" : "black")
+		            <<  parentStr << std::endl;
+
+		printBinaryTree(prefix + (isLeft ? "│   " : "    "), node->m_left, true);
+		printBinaryTree(prefix + (isLeft ? "│   " : "    "), node->m_right, false);
+	}
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+size_t RedBlackTree<K, V, Storage, Compare>::subtreeHeight(const NodePtr& node) const {
+	if (!node) {
+		return 0;
+	}
+
+	return std::max(subtreeHeight(node->m_left), subtreeHeight(node->m_right)) + 1;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+size_t RedBlackTree<K, V, Storage, Compare>::subtreeBlackHeight(const NodePtr& node) const {
+	if (!node) {
+		return 1;
+	}
+
+	if (isRed(node) && (isRed(node->m_left) || isRed(node->m_right))) {
+		return 0;
+	}
+
+	const auto left = subtreeBlackHeight(node->m_left);
+	if (left == 0 || left != subtreeBlackHeight(node->m_right)) {
+		return 0;
+	}
+
+	return isRed(node) ? left : left + 1;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::fixSize(const NodePtr& node) {
+	if (node) {
+		node->m_size = this->safeGetSize(node->m_left) + this->safeGetSize(node->m_right) + 1;
+	}
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::fixSizesUpwards(NodePtr node) {
+	while (node) {
+		fixSize(node);
+		node = node->parent();
+	}
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename Key>
+typename RedBlackTree<K, V, Storage, Compare>::NodePtr RedBlackTree<K, V, Storage, Compare>::find(const NodePtr& node, const Key& key) const {
+	auto link = &node;
+
+	while (*link) {
+		const auto order = this->compareKeys(key, (*link)->m_keyValue.first);
+		if (order == 0) {
+			break;
+		}
+
+		link = order < 0 ? &(*link)->m_left : &(*link)->m_right;
+	}
+
+	return *link;
+}
+
+// Links the new node as a red leaf after the equal keys, sizes grow on the way down.
+template <typename K, typename V, typename Storage, typename Compare> template <typename... Args>
+typename RedBlackTree<K, V, Storage, Compare>::NodePtr RedBlackTree<K, V, Storage, Compare>::emplaceNode(Args&&... args) {
+	auto node = this->template createNode<Node>(std::in_place, std::forward<Args>(args)...);
+	const auto& key = node->m_keyValue.first;
+
+	auto link = &this->m_rootNode;
+	NodePtr* parentLink = nullptr;
+
+	while (*link) {
+		parentLink = link;
+		++(*link)->m_size;
+		link = this->keyLess(key, (*link)->m_keyValue.first) ? &(*link)->m_left : &(*link)->m_right;
+	}
+
+	*link = node;
+	node->m_parent = parentLink ? *parentLink : NodePtr{};
+	++this->m_size;
+
+	fixAfterInsert(node);
+
+	return node;
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename Key, typename Create>
+std::pair<typename RedBlackTree<K, V, Storage, Compare>::NodePtr, bool> RedBlackTree<K, V, Storage, Compare>::findOrInsert(const Key& key, Create&& create) {
+	auto link = &this->m_rootNode;
+	NodePtr* parentLink = nullptr;
+
+	while (*link) {
+		const auto order = this->compareKeys(key, (*link)->m_keyValue.first);
+		if (order == 0) {
+			return std::make_pair(*link, false);
+		}
+
+		parentLink = link;
+		link = order < 0 ? &(*link)->m_left : &(*link)->m_right;
+	}
+
+	auto inserted = create();
+	*link = inserted;
+	inserted->m_parent = parentLink ? *parentLink : NodePtr{};
+	++this->m_size;
+
+	for (auto node = inserted->parent(); node; node = node->parent()) {
+		++node->m_size;
+	}
+
+	fixAfterInsert(inserted);
+
+	return std::make_pair(inserted, true);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+typename RedBlackTree<K, V, Storage, Compare>::NodePtr& RedBlackTree<K, V, Storage, Compare>::linkOf(const NodePtr& node, const NodePtr& parent) {
+	return !parent ? this->m_rootNode : (parent->m_left == node ? parent->m_left : parent->m_right);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::transplant(const NodePtr& node, const NodePtr& parent, const NodePtr& replacement) {
+	linkOf(node, parent) = replacement;
+
+	if (replacement) {
+		replacement->m_parent = parent;
+	}
+}
+
+// Lifts the right child of node into its place, the sizes of both are recomputed.
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::rotateLeft(NodePtr node) {
+	auto pivot = node->m_right;
+
+	linkOf(node, node->parent()) = pivot;
+	pivot->m_parent = node->m_parent;
+
+	node->m_right = pivot->m_left;
+	if (node->m_right) {
+		node->m_right->m_parent = node;
+	}
+
+	pivot->m_left = node;
+	node->m_parent = pivot;
+
+	pivot->m_size = node->m_size;
+	fixSize(node);
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::rotateRight(NodePtr node) {
+	auto pivot = node->m_left;
+
+	linkOf(node, node->parent()) = pivot;
+	pivot->m_parent = node->m_parent;
+
+	node->m_left = pivot->m_right;
+	if (node->m_left) {
+		node->m_left->m_parent = node;
+	}
+
+	pivot->m_right = node;
+	node->m_parent = pivot;
+
+	pivot->m_size = node->m_size;
+	fixSize(node);
+}
+
+// A red parent is never the root, so it has a parent of its own. The mirrored cases share the code through parentIsLeft.
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::fixAfterInsert(NodePtr node) {
+	for (auto parent = node->parent(); isRed(parent); parent = node->parent()) {
+		auto grandparent = parent->parent();
+		const auto parentIsLeft = grandparent->m_left == parent;
+		const auto& uncle = parentIsLeft ? grandparent->m_right : grandparent->m_left;
+
+		// A red uncle: the grandparent takes the red up, no rotation.
+		if (isRed(uncle)) {
+			paint(parent, false);
+			paint(uncle, false);
+			paint(grandparent, true);
+			node = grandparent;
+			continue;
+		}
+
+		// An inner grandchild is first rotated to the outside.
+		if (parentIsLeft && parent->m_right == node) {
+			rotateLeft(parent);
+			parent = node;
+		} else if (!parentIsLeft && parent->m_left == node) {
+			rotateRight(parent);
+			parent = node;
+		}
+
+		paint(parent, false);
+		paint(grandparent, true);
+
+		if (parentIsLeft) {
+			rotateRight(grandparent);
+		} else {
+			rotateLeft(grandparent);
+		}
+
+		break;
+	}
+
+	paint(this->m_rootNode, false);
+}
+
+// node carries an extra black. While its sibling cannot give a red away, the extra black moves up.
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::fixAfterRemove(NodePtr node, NodePtr parent) {
+	while (parent && !isRed(node)) {
+		// The side of node is the empty one if node is empty, its sibling then has at least one black node.
+		const auto nodeIsLeft = parent->m_left == node;
+		auto sibling = nodeIsLeft ? parent->m_right : parent->m_left;
+
+		// A red sibling is rotated above parent, the new sibling is black.
+		if (isRed(sibling)) {
+			paint(sibling, false);
+			paint(parent, true);
+
+			if (nodeIsLeft) {
+				rotateLeft(parent);
+			} else {
+				rotateRight(parent);
+			}
+
+			sibling = nodeIsLeft ? parent->m_right : parent->m_left;
+		}
+
+		auto outer = nodeIsLeft ? sibling->m_right : sibling->m_left;
+		const auto& inner = nodeIsLeft ? sibling->m_left : sibling->m_right;
+
+		if (!isRed(outer) && !isRed(inner)) {
+			paint(sibling, true);
+			node = parent;
+			parent = node->parent();
+			continue;
+		}
+
+		// A red inner nephew is first rotated to the outside.
+		if (!isRed(outer)) {
+			paint(inner, false);
+			paint(sibling, true);
+
+			if (nodeIsLeft) {
+				rotateRight(sibling);
+			} else {
+				rotateLeft(sibling);
+			}
+
+			sibling = nodeIsLeft ? parent->m_right : parent->m_left;
+			outer = nodeIsLeft ? sibling->m_right : sibling->m_left;
+		}
+
+		paint(sibling, isRed(parent));
+		paint(parent, false);
+		paint(outer, false);
+
+		if (nodeIsLeft) {
+			rotateLeft(parent);
+		} else {
+			rotateRight(parent);
+		}
+
+		return;
+	}
+
+	if (node) {
+		paint(node, false);
+	}
+}
+
+template <typename K, typename V, typename Storage, typename Compare> template <typename Key>
+typename RedBlackTree<K, V, Storage, Compare>::NodePtr RedBlackTree<K, V, Storage, Compare>::detach(const Key& key) {
+	auto node = find(this->m_rootNode, key);
+	if (node) {
+		unlinkNode(node);
+	}
+
+	return node;
+}
+
+// A node with two children is replaced by its successor, which takes over its colour. The colour rules
+// are then restored below the position that lost a node, whose sizes are recomputed up to the root first.
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::unlinkNode(const NodePtr& node) {
+	const auto parent = node->parent();
+	auto removedRed = isRed(node);
+	NodePtr child{};
+	NodePtr childParent{};
+
+	if (!node->m_left || !node->m_right) {
+		child = node->m_left ? node->m_left : node->m_right;
+		childParent = parent;
+		transplant(node, parent, child);
+	} else {
+		auto successor = node->m_right;
+		while (successor->m_left) {
+			successor = successor->m_left;
+		}
+
+		removedRed = isRed(successor);
+		child = successor->m_right;
+
+		if (successor == node->m_right) {
+			childParent = successor;
+		} else {
+			childParent = successor->parent();
+			transplant(successor, childParent, child);
+			successor->m_right = node->m_right;
+			successor->m_right->m_parent = successor;
+		}
+
+		transplant(node, parent, successor);
+		successor->m_left = node->m_left;
+		successor->m_left->m_parent = successor;
+		paint(successor, isRed(node));
+	}
+
+	node->m_left = nullptr;
+	node->m_right = nullptr;
+	node->m_parent = {};
+	--this->m_size;
+
+	fixSizesUpwards(childParent);
+
+	if (!removedRed) {
+		fixAfterRemove(child, childParent);
+	}
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+typename RedBlackTree<K, V, Storage, Compare>::NodePtr RedBlackTree<K, V, Storage, Compare>::cloneSubtree(const NodePtr& node) {
+	if (!node) {
+		return NodePtr{};
+	}
+
+	auto copy = this->template createNode<Node>(node->m_keyValue);
+	copy->m_size = node->m_size;
+	paint(copy, isRed(node));
+	copy->m_left = cloneSubtree(node->m_left);
+	copy->m_right = cloneSubtree(node->m_right);
+
+	if (copy->m_left) {
+		copy->m_left->m_parent = copy;
+	}
+
+	if (copy->m_right) {
+		copy->m_right->m_parent = copy;
+	}
+
+	return copy;
+}
+
+template <typename K, typename V, typename Storage, typename Compare>
+void RedBlackTree<K, V, Storage, Compare>::paintLevels(const NodePtr& node, size_t depth, size_t redDepth) {
+	if (node) {
+		paint(node, depth == redDepth);
+		paintLevels(node->m_left, depth + 1, redDepth);
+		paintLevels(node->m_right, depth + 1, redDepth);
+	}
+}
@@ -0,0 +1,331 @@
+#include "RedBlackTree.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// No red node has a red child and every path has as many black nodes, which bounds the height by 2 log2(n + 1).
+template <typename Tree>
+bool balanced(const Tree& tree) {
+	return tree.blackHeight() != 0 && static_cast<double>(tree.height()) <= 2 * std::log2(static_cast<double>(tree.size()) + 1);
+}
+
+// The shape, colours and parents of a tree as printed by printTree().
+template <typename Tree>
+std::string printedTree(const Tree& tree) {
+	std::ostringstream out;
+	auto* oldBuffer = std::cout.rdbuf(out.rdbuf());
+	tree.printTree();
+	std::cout.rdbuf(oldBuffer);
+	return out.str();
+}
+
+std::vector<int> shuffledKeys(size_t count, unsigned seed) {
+	std::vector<int> keys(count);
+	for (size_t i = 0; i < count; ++i) {
+		keys[i] = static_cast<int>(i);
+	}
+
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+	return keys;
+}
+
+// Checks a tree against std::multimap under random inserts and removes, including the order statistics
+// kept up to date by the rotations.
+template <typename Storage>
+void randomizedTest(size_t operations, size_t keyRange) {
+	RedBlackTree<int, int, Storage> tree;
+	std::multimap<int, int> expected;
+	std::mt19937 random(5);
+
+	for (size_t step = 0; step < operations; ++step) {
+		const auto key = static_cast<int>(random() % keyRange);
+
+		if (random() % 3 != 0) {
+			tree.insert(key, static_cast<int>(step));
+			expected.emplace(key, static_cast<int>(step));
+		} else {
+			const auto found = expected.find(key);
+			const auto removed = tree.remove(key);
+			assert(removed == (found != expected.end()));
+
+			if (found != expected.end()) {
+				expected.erase(found);
+			}
+		}
+
+		if (step % 1000 == 0) {
+			assert(balanced(tree));
+		}
+	}
+
+	assert(tree.size() == expected.size() && balanced(tree));
+	assert(std::equal(tree.begin(), tree.end(), expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.first == rhs.first;
+	}));
+
+	for (size_t i = 0; i < keyRange; ++i) {
+		const auto key = static_cast<int>(i);
+		const auto rank = static_cast<size_t>(std::distance(expected.begin(), expected.lower_bound(key)));
+
+		assert(tree.rank(key) == rank);
+		assert(rank == expected.size() ? tree.select(rank) == tree.end() : tree.select(rank)->first == expected.lower_bound(key)->first);
+	}
+
+	while (!expected.empty()) {
+		const auto removed = tree.remove(expected.begin()->first);
+		assert(removed);
+		expected.erase(expected.begin());
+	}
+
+	assert(tree.size() == 0 && tree.begin() == tree.end() && tree.height() == 0);
+}
+
+int main() {
+	RedBlackTree<int, std::string> tree;
+
+	/* insertion */
+
+	// Ascending keys degenerate an unbalanced tree into a list.
+	for (auto i = 0; i < 10000; ++i) {
+		tree.insert(i, std::to_string(i));
+	}
+
+	assert(tree.size() == 10000 && balanced(tree));
+
+	for (auto i = 0; i < 10000; ++i) {
+		assert(tree.find(i)->second == std::to_string(i));
+	}
+
+	assert(tree.find(10000) == tree.end() && !tree.contains(-1));
+
+	std::cout << "Insertion OK" << std::endl;
+
+	/* removal */
+
+	for (auto i = 0; i < 10000; i += 2) {
+		const auto removed = tree.remove(i);
+		assert(removed);
+	}
+
+	const auto removedTwice = tree.remove(0);
+	assert(!removedTwice);
+	assert(tree.size() == 5000 && balanced(tree));
+
+	for (auto i = 0; i < 10000; ++i) {
+		assert(tree.contains(i) == (i % 2 != 0));
+	}
+
+	const auto extracted = tree.extract(1);
+	const auto extractedTwice = tree.extract(1);
+	assert(extracted == std::string("1") && !extractedTwice);
+	assert(tree.size() == 4999 && tree.begin()->first == 3);
+
+	std::cout << "Removal OK" << std::endl;
+
+	/* equal keys */
+
+	RedBlackTree<int, int> duplicates;
+	for (auto i = 0; i < 300; ++i) {
+		duplicates.insert(i % 3, i);
+	}
+
+	assert(duplicates.size() == 300 && balanced(duplicates));
+	assert(duplicates.countRange(1, 1) == 100 && duplicates.rank(2) == 200);
+
+	auto order = 1;
+	for (const auto& item : duplicates.range(1, 1)) {
+		assert(item.second == order);
+		order += 3;
+	}
+
+	std::cout << "Equal keys OK" << std::endl;
+
+	/* colour rules */
+
+	// Ascending, descending and zig-zag keys run into every case of both fix-ups, the rules are checked after each.
+	RedBlackTree<int, int> painted;
+	std::vector<int> paintedKeys;
+	for (auto i = 0; i < 300; ++i) {
+		for (const auto key : { i, 1000 - i, 500 + (i % 2 != 0 ? i : -i) }) {
+			painted.insert(key, i);
+			paintedKeys.push_back(key);
+			assert(balanced(painted));
+		}
+	}
+
+	assert(painted.size() == 900 && painted.blackHeight() > 1);
+
+	std::shuffle(paintedKeys.begin(), paintedKeys.end(), std::mt19937(3));
+	for (const auto key : paintedKeys) {
+		const auto removed = painted.remove(key);
+		assert(removed && balanced(painted));
+	}
+
+	assert(painted.size() == 0 && painted.blackHeight() == 1);
+
+	std::cout << "Colour rules OK" << std::endl;
+
+	/* insert or assign */
+
+	// New keys are linked as red leaves in the same descent and repainted like inserts, present keys leave the tree as it is.
+	RedBlackTree<int, std::string> assignedTree;
+	for (auto i = 0; i < 1000; ++i) {
+		const auto tried = assignedTree.tryEmplace(i, 2, 'x');
+		assert(tried.second && tried.first->second == "xx" && balanced(assignedTree));
+	}
+
+	const auto assignedHeight = assignedTree.height();
+	const auto assignedBlackHeight = assignedTree.blackHeight();
+
+	for (auto i = 0; i < 1000; ++i) {
+		const auto assigned = assignedTree.insertOrAssign(i, std::to_string(i));
+		const auto tried = assignedTree.tryEmplace(i, "unused");
+		assert(!assigned.second && !tried.second && tried.first->second == std::to_string(i));
+	}
+
+	assert(assignedTree.size() == 1000 && assignedTree.height() == assignedHeight && assignedTree.blackHeight() == assignedBlackHeight);
+
+	for (auto i = -1; i >= -1000; --i) {
+		const auto assigned = assignedTree.insertOrAssign(i, std::to_string(i));
+		assert(assigned.second && assigned.first->first == i && balanced(assignedTree));
+	}
+
+	assert(assignedTree.size() == 2000 && assignedTree.begin()->second == "-1000");
+
+	std::cout << "Insert or assign OK" << std::endl;
+
+	/* iterators */
+
+	// Iterators from lookups carry no path and step back through the parent links, which rotations keep rewiring.
+	RedBlackTree<int, int> walked;
+	for (const auto key : shuffledKeys(3000, 17)) {
+		walked.insert(key, key);
+	}
+
+	for (auto key = 0; key < 3000; key += 3) {
+		const auto removed = walked.remove(key);
+		assert(removed);
+	}
+
+	assert(walked.size() == 2000 && balanced(walked));
+
+	for (auto key = 2; key < 3000; ++key) {
+		if (key % 3 == 0) {
+			continue;
+		}
+
+		auto found = walked.find(key);
+		--found;
+		assert(found->first == (key % 3 == 1 ? key - 2 : key - 1));
+		++found;
+		assert(found->first == key);
+	}
+
+	for (size_t rank = 1; rank < walked.size(); ++rank) {
+		auto selected = walked.select(rank);
+		selected--;
+		assert(selected->first == walked.select(rank - 1)->first);
+	}
+
+	auto walkedBack = walked.find(2999);
+	auto steps = size_t{ 0 };
+	while (walkedBack != walked.begin()) {
+		--walkedBack;
+		++steps;
+	}
+
+	auto walkedLast = walked.end();
+	--walkedLast;
+	assert(steps == walked.size() - 1 && walkedBack->first == 1 && walkedLast->first == 2999);
+
+	std::cout << "Iterators OK" << std::endl;
+
+	/* bulk load */
+
+	// Sorted items are linked by halving and only the deepest level, when incomplete, is painted red:
+	// every size gets the least height and a black height of one more than its complete levels.
+	for (size_t count = 0; count <= 300; ++count) {
+		std::vector<std::pair<int, int>> sortedItems;
+		for (size_t k = 0; k < count; ++k) {
+			sortedItems.emplace_back(static_cast<int>(k), static_cast<int>(k));
+		}
+
+		RedBlackTree<int, int> loaded(sortedItems.begin(), sortedItems.end());
+
+		auto completeLevels = size_t{ 0 };
+		while ((size_t{ 1 } << (completeLevels + 1)) <= count + 1) {
+			++completeLevels;
+		}
+
+		const auto leastHeight = (size_t{ 1 } << completeLevels) == count + 1 ? completeLevels : completeLevels + 1;
+		assert(loaded.size() == count && loaded.height() == leastHeight && loaded.blackHeight() == completeLevels + 1);
+
+		loaded.insert(static_cast<int>(count), 0);
+		const auto removed = loaded.remove(0);
+		assert(removed && loaded.size() == count && balanced(loaded));
+	}
+
+	std::vector<std::pair<int, int>> items;
+	for (auto i = 0; i < 1000; ++i) {
+		items.emplace_back((i * 7919) % 1000, i);
+	}
+
+	RedBlackTree<int, int> loaded(items.begin(), items.end());
+	assert(loaded.size() == 1000 && balanced(loaded));
+	assert(loaded.rank(500) == 500 && loaded.select(999)->first == 999);
+
+	for (auto i = 1000; i < 3000; ++i) {
+		loaded.insert(i, i);
+		loaded.remove(i - 1000);
+	}
+
+	assert(loaded.size() == 1000 && loaded.begin()->first == 2000 && balanced(loaded));
+
+	std::cout << "Bulk load OK" << std::endl;
+
+	/* copy and move */
+
+	// Copies reproduce the structure and colours node by node, with parent links of their own.
+	const auto walkedShape = printedTree(walked);
+
+	auto copied = walked;
+	RedBlackTree<int, int> assignedCopy;
+	assignedCopy = walked;
+	assert(printedTree(copied) == walkedShape && printedTree(assignedCopy) == walkedShape);
+
+	walked.clear();
+
+	auto copiedIt = copied.find(1001);
+	--copiedIt;
+	assert(copiedIt->first == 1000 && walked.size() == 0);
+
+	for (auto key = 0; key < 3000; key += 2) {
+		copied.remove(key);
+	}
+
+	assert(copied.size() == 1000 && balanced(copied) && printedTree(assignedCopy) == walkedShape);
+
+	auto moved = std::move(copied);
+	auto movedLast = moved.end();
+	--movedLast;
+	assert(moved.size() == 1000 && movedLast->first == 2999 && balanced(moved));
+
+	std::cout << "Copy and move OK" << std::endl;
+
+	/* randomized */
+
+	randomizedTest<SharedNodeStorage>(100000, 5000);
+	randomizedTest<ArenaNodeStorage>(100000, 500);
+
+	std::cout << "Randomized OK" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/btree_benchmark"
+  "/root/repo/btree_benchmark.pdb"
+  "CMakeFiles/btree_benchmark.dir/main.cpp.o"
+  "CMakeFiles/btree_benchmark.dir/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/btree_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/btree_test"
+  "/root/repo/btree_test.pdb"
+  "CMakeFiles/btree_test.dir/main.cpp.o"
+  "CMakeFiles/btree_test.dir/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/btree_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
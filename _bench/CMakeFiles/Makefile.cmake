@@ -0,0 +1,94 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/Abstract BST/CMakeLists.txt"
+  "/root/repo/B Tree/CMakeLists.txt"
+  "/root/repo/B Tree/benchmark/CMakeLists.txt"
+  "/root/repo/B Tree/btree/CMakeLists.txt"
+  "/root/repo/B Tree/test/CMakeLists.txt"
+  "/root/repo/CMakeLists.txt"
+  "/root/repo/Expression BST/CMakeLists.txt"
+  "/root/repo/Expression BST/ebst/CMakeLists.txt"
+  "/root/repo/Expression BST/test/CMakeLists.txt"
+  "/root/repo/Randomized BST/CMakeLists.txt"
+  "/root/repo/Randomized BST/benchmark/CMakeLists.txt"
+  "/root/repo/Randomized BST/rbst/CMakeLists.txt"
+  "/root/repo/Randomized BST/test/CMakeLists.txt"
+  "/root/repo/Red Black Tree/CMakeLists.txt"
+  "/root/repo/Red Black Tree/benchmark/CMakeLists.txt"
+  "/root/repo/Red Black Tree/rbtree/CMakeLists.txt"
+  "/root/repo/Red Black Tree/test/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/root/repo/cmake/AddDirectory.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckCSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckIncludeFile.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckLibraryExists.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageHandleStandardArgs.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageMessage.cmake"
+  "/usr/share/cmake-3.25/Modules/FindThreads.cmake"
+  "/usr/share/cmake-3.25/Modules/Internal/CheckSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Abstract BST/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Randomized BST/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Randomized BST/rbst/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Randomized BST/test/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Randomized BST/benchmark/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Expression BST/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Expression BST/ebst/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Expression BST/test/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "B Tree/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "B Tree/btree/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "B Tree/test/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "B Tree/benchmark/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Red Black Tree/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Red Black Tree/rbtree/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Red Black Tree/test/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "Red Black Tree/benchmark/CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "Randomized BST/test/CMakeFiles/rbst_test.dir/DependInfo.cmake"
+  "Randomized BST/benchmark/CMakeFiles/rbst_benchmark.dir/DependInfo.cmake"
+  "Expression BST/ebst/CMakeFiles/ebst.dir/DependInfo.cmake"
+  "Expression BST/test/CMakeFiles/ebst_test.dir/DependInfo.cmake"
+  "B Tree/test/CMakeFiles/btree_test.dir/DependInfo.cmake"
+  "B Tree/benchmark/CMakeFiles/btree_benchmark.dir/DependInfo.cmake"
+  "Red Black Tree/test/CMakeFiles/rbtree_test.dir/DependInfo.cmake"
+  "Red Black Tree/benchmark/CMakeFiles/rbtree_benchmark.dir/DependInfo.cmake"
+  )
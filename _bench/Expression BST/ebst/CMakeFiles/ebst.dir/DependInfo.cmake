@@ -0,0 +1,28 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Expression BST/ebst/EBST.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/EBST.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/EBST.cpp.o.d"
+  "/root/repo/Expression BST/ebst/ExpressionException.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/ExpressionException.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/ExpressionException.cpp.o.d"
+  "/root/repo/Expression BST/ebst/ExpressionNode.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/ExpressionNode.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/ExpressionNode.cpp.o.d"
+  "/root/repo/Expression BST/ebst/NodeBalancing.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeBalancing.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeBalancing.cpp.o.d"
+  "/root/repo/Expression BST/ebst/NodeHelpers.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeHelpers.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeHelpers.cpp.o.d"
+  "/root/repo/Expression BST/ebst/NodeOutput.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeOutput.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeOutput.cpp.o.d"
+  "/root/repo/Expression BST/ebst/NodeReduce.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeReduce.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeReduce.cpp.o.d"
+  "/root/repo/Expression BST/ebst/NodeRules.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeRules.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeRules.cpp.o.d"
+  "/root/repo/Expression BST/ebst/NodeSimplifiers.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeSimplifiers.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeSimplifiers.cpp.o.d"
+  "/root/repo/Expression BST/ebst/NodeSolver.cpp" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeSolver.cpp.o" "gcc" "Expression BST/ebst/CMakeFiles/ebst.dir/NodeSolver.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,29 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ebst.dir/EBST.cpp.o"
+  "CMakeFiles/ebst.dir/EBST.cpp.o.d"
+  "CMakeFiles/ebst.dir/ExpressionException.cpp.o"
+  "CMakeFiles/ebst.dir/ExpressionException.cpp.o.d"
+  "CMakeFiles/ebst.dir/ExpressionNode.cpp.o"
+  "CMakeFiles/ebst.dir/ExpressionNode.cpp.o.d"
+  "CMakeFiles/ebst.dir/NodeBalancing.cpp.o"
+  "CMakeFiles/ebst.dir/NodeBalancing.cpp.o.d"
+  "CMakeFiles/ebst.dir/NodeHelpers.cpp.o"
+  "CMakeFiles/ebst.dir/NodeHelpers.cpp.o.d"
+  "CMakeFiles/ebst.dir/NodeOutput.cpp.o"
+  "CMakeFiles/ebst.dir/NodeOutput.cpp.o.d"
+  "CMakeFiles/ebst.dir/NodeReduce.cpp.o"
+  "CMakeFiles/ebst.dir/NodeReduce.cpp.o.d"
+  "CMakeFiles/ebst.dir/NodeRules.cpp.o"
+  "CMakeFiles/ebst.dir/NodeRules.cpp.o.d"
+  "CMakeFiles/ebst.dir/NodeSimplifiers.cpp.o"
+  "CMakeFiles/ebst.dir/NodeSimplifiers.cpp.o.d"
+  "CMakeFiles/ebst.dir/NodeSolver.cpp.o"
+  "CMakeFiles/ebst.dir/NodeSolver.cpp.o.d"
+  "libebst.a"
+  "libebst.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ebst.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
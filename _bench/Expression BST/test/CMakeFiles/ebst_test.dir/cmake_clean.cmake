@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/ebst_test"
+  "/root/repo/ebst_test.pdb"
+  "CMakeFiles/ebst_test.dir/main.cpp.o"
+  "CMakeFiles/ebst_test.dir/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ebst_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/rbst_benchmark"
+  "/root/repo/rbst_benchmark.pdb"
+  "CMakeFiles/rbst_benchmark.dir/main.cpp.o"
+  "CMakeFiles/rbst_benchmark.dir/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/rbst_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
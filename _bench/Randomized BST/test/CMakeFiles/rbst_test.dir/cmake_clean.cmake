@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/rbst_test"
+  "/root/repo/rbst_test.pdb"
+  "CMakeFiles/rbst_test.dir/main.cpp.o"
+  "CMakeFiles/rbst_test.dir/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/rbst_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
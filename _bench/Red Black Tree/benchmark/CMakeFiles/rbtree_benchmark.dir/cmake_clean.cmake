@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/rbtree_benchmark"
+  "/root/repo/rbtree_benchmark.pdb"
+  "CMakeFiles/rbtree_benchmark.dir/main.cpp.o"
+  "CMakeFiles/rbtree_benchmark.dir/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/rbtree_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/rbtree_test"
+  "/root/repo/rbtree_test.pdb"
+  "CMakeFiles/rbtree_test.dir/main.cpp.o"
+  "CMakeFiles/rbtree_test.dir/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/rbtree_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()